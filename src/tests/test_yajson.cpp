@@ -1,5 +1,13 @@
 #include "../yajson/yajson.h"
 #include <stdio.h>
+#include <cstring>
+#include <functional>
+#include <sstream>
+#include <unordered_set>
+#include <mutex>
+#include <thread>
+#include <cmath>
+#include <unistd.h>
 
 static auto json = R"(
     {
@@ -216,6 +224,7 @@ static bool testNull() {
     success = success && !j1.has("anything");
     success = success && j1.format() == "null";
 
+#ifndef YAJSON_NO_EXCEPTIONS
     try {
         j1.set("anything", "value");
         success = false;
@@ -280,6 +289,7 @@ static bool testNull() {
         j1.erase("anything");
         success = false;
     } catch(const std::domain_error&) {}
+#endif
 
     success = success && j1 == j2;
 
@@ -346,6 +356,7 @@ static bool testWrongType() {
     bool success = true;
     auto j1 = yajson::Value::parse(json);
 
+#ifndef YAJSON_NO_EXCEPTIONS
     try {
         j1.boolean();
         success = false;
@@ -430,6 +441,7 @@ static bool testWrongType() {
         j1["test\"me\""][0].insert("value");
         success = false;
     } catch(const std::domain_error&) {}
+#endif
 
     if (!success) {
         printf("FAIL %s\n", __func__);
@@ -441,13 +453,14 @@ static bool testWrongType() {
 static bool testInvalidJson() {
     bool success = true;
 
+#ifndef YAJSON_NO_EXCEPTIONS
     try {
         yajson::Value::parse("[trust]");
         success = false;
     } catch(const std::invalid_argument&) {}
 
     try {
-        yajson::Value::parse("[9223372036854775808]");
+        yajson::Value::parse("[9223372036854775808]")[0].integer();
         success = false;
     } catch(const std::invalid_argument&) {}
 
@@ -471,6 +484,7 @@ static bool testInvalidJson() {
         j.format();
         success = false;
     } catch(const std::invalid_argument&) {}    
+#endif
 
     if (!success) {
         printf("FAIL %s\n", __func__);
@@ -573,6 +587,2151 @@ static bool testArrayInsertConditions() {
     return success;
 }
 
+static bool testConstLookup() {
+    bool success = true;
+    const auto j = yajson::Value::parse(json);
+    const auto before = j.format();
+
+    success = success && j.find("missing") == nullptr;
+    success = success && j.find("test\"me\"") != nullptr;
+    success = success && j.find("test\"me\"")->find(10) == nullptr;
+    success = success && j.find("test\"me\"")->find(0)->integer() == 1;
+    success = success && j["missing"].isNull();
+    success = success && j["test\"me\""][42].isNull();
+    success = success && j["test\"me\""][2]["missing"].isNull();
+    success = success && j.at("test\"me\"").at(9).string() == "C:\\";
+    success = success && yajson::Value().find("key") == nullptr;
+    success = success && yajson::Value().find(0) == nullptr;
+    success = success && j.format() == before;
+    success = success && j.count() == 1;
+    success = success && j["test\"me\""].count() == 10;
+
+#ifndef YAJSON_NO_EXCEPTIONS
+    try {
+        j.at("missing");
+        success = false;
+    } catch(const std::out_of_range&) {}
+
+    try {
+        j.at("test\"me\"").at(10);
+        success = false;
+    } catch(const std::out_of_range&) {}
+
+    try {
+        j.find(0);
+        success = false;
+    } catch(const std::domain_error&) {}
+
+    try {
+        yajson::Value().at("key");
+        success = false;
+    } catch(const std::domain_error&) {}
+
+    try {
+        yajson::Value().at(0);
+        success = false;
+    } catch(const std::domain_error&) {}
+#endif
+
+    auto mutableJson = yajson::Value::parse(json);
+
+    mutableJson.at("test\"me\"").at(0) = 5;
+    success = success && mutableJson.find("test\"me\"")->find(0)->integer() == 5;
+    mutableJson.find("test\"me\"")->find(2)->clear();
+    success = success && mutableJson["test\"me\""][2].count() == 0;
+    success = success && mutableJson.count() == 1;
+
+    if (!success) {
+        printf("FAIL %s\n", __func__);
+    }
+
+    return success;
+}
+
+static bool testTryParse() {
+    struct Case {
+        const char* text;
+        yajson::Value::ParseError::Code code;
+        size_t offset;
+    };
+    const Case cases[] = {
+        {"", yajson::Value::ParseError::UnexpectedEnd, 0},
+        {"  ", yajson::Value::ParseError::UnexpectedEnd, 2},
+        {"[trust]", yajson::Value::ParseError::InvalidLiteral, 1},
+        {"[...]", yajson::Value::ParseError::UnexpectedCharacter, 1},
+        {"[#]", yajson::Value::ParseError::UnexpectedCharacter, 1},
+        {"[1 2]", yajson::Value::ParseError::UnexpectedCharacter, 3},
+        {"[1", yajson::Value::ParseError::UnexpectedEnd, 2},
+        {"[", yajson::Value::ParseError::UnexpectedEnd, 1},
+        {"{", yajson::Value::ParseError::UnexpectedEnd, 1},
+        {"{1:2}", yajson::Value::ParseError::UnexpectedCharacter, 1},
+        {"{\"a\" 2}", yajson::Value::ParseError::UnexpectedCharacter, 5},
+        {"{\"a\"", yajson::Value::ParseError::UnexpectedEnd, 4},
+        {"{\"a\":}", yajson::Value::ParseError::UnexpectedCharacter, 5},
+        {"{\"a", yajson::Value::ParseError::UnexpectedEnd, 3},
+        {"{\"a\":1 \"b\":2}", yajson::Value::ParseError::UnexpectedCharacter, 7},
+        {"{\"a\":1", yajson::Value::ParseError::UnexpectedEnd, 6},
+        {"{\"a\":1,", yajson::Value::ParseError::UnexpectedEnd, 7},
+        {"\"\\", yajson::Value::ParseError::UnexpectedEnd, 2},
+        {"\"\\i\"", yajson::Value::ParseError::InvalidEscape, 2},
+        {"\"\\u12\"", yajson::Value::ParseError::InvalidEscape, 5},
+        {"\"\\u12", yajson::Value::ParseError::UnexpectedEnd, 5},
+        {"\"\\u{}\"", yajson::Value::ParseError::InvalidEscape, 4},
+        {"\"\\u{12", yajson::Value::ParseError::UnexpectedEnd, 6},
+        {"\"\\u{110000}\"", yajson::Value::ParseError::InvalidCodepoint, 2},
+        // RFC 8259 grammar: leading zeros and trailing text fail rather than parse a prefix
+        {"007", yajson::Value::ParseError::UnexpectedCharacter, 1},
+        {"01", yajson::Value::ParseError::UnexpectedCharacter, 1},
+        {"-01", yajson::Value::ParseError::UnexpectedCharacter, 2},
+        {"1.5.3", yajson::Value::ParseError::UnexpectedCharacter, 3},
+        {"[1] x", yajson::Value::ParseError::UnexpectedCharacter, 4},
+        {"+1", yajson::Value::ParseError::UnexpectedCharacter, 0},
+        {"1.", yajson::Value::ParseError::InvalidNumber, 0},
+        {"[1,]", yajson::Value::ParseError::UnexpectedCharacter, 3},
+        {"{\"a\":1,}", yajson::Value::ParseError::UnexpectedCharacter, 7},
+        {"\v1", yajson::Value::ParseError::UnexpectedCharacter, 0},
+    };
+    bool success = true;
+    yajson::Value value = 42;
+    yajson::Value::ParseError error;
+    size_t offset = 1;
+
+    success = success && error.code == yajson::Value::ParseError::None;
+    success = success && std::string(error.message()) == "No error";
+
+    for (const auto& test : cases) {
+        const bool parsed = yajson::Value::tryParse(test.text, value, error);
+
+        if (parsed || (error.code != test.code) || (error.offset != test.offset)) {
+            printf("FAIL: %s -> %s @ %d\n", test.text, error.message(), int(error.offset));
+            success = false;
+        }
+    }
+
+    success = success && value.integer() == 42; // untouched on failure
+    success = success && yajson::Value::tryParse(json, value, error);
+    success = success && value == yajson::Value::parse(json);
+    success = success && yajson::Value::tryParse(" [1, {\"a\": \"\\u{1F60D}\"}] [2]", value, error, &offset);
+    success = success && offset == 24;
+    success = success && yajson::Value::tryParse(" [1, {\"a\": \"\\u{1F60D}\"}] [2]", value, error, &offset);
+    success = success && value.count() == 1 && value[0].integer() == 2;
+    success = success && yajson::Value::tryParse("truefalse", 4, value, error);
+    success = success && value.boolean();
+    success = success && yajson::Value::tryParse(" [1]\n ", value, error) && value.count() == 1;
+    offset = 0;
+    success = success && yajson::Value::tryParse("01", value, error, &offset); // a sequence of values
+    success = success && value.integer() == 0 && offset == 1;
+    success = success && !yajson::Value::tryParseInto("[1] x", value, error) && value.isNull();
+    success = success && !yajson::Value::tryParseParallel("[1] x", 5, 2, value, error);
+    success = success && !yajson::Value::tryParse("{} x", 4, yajson::Projection({"/a"}), value, error);
+
+    int bound = 0;
+
+    success = success && !yajson::Binding::tryParse("007", bound, error) && error.offset == 1;
+
+#ifndef YAJSON_NO_EXCEPTIONS
+    try {
+        yajson::Value::parse("[1 2]");
+        success = false;
+    } catch(const std::invalid_argument& exception) {
+        success = success && std::string(exception.what()) == "Unexpected character at offset 3";
+    }
+
+    try {
+        yajson::Value::array().find("key");
+        success = false;
+    } catch(const std::domain_error&) {}
+#endif
+
+    if (!success) {
+        printf("FAIL %s\n", __func__);
+    }
+
+    return success;
+}
+
+static bool testValidate() {
+    const char* const valid[] = {
+        "0", "-0", "1.5", "-12.25e+10", "1E-2", "true", "false", "null", "\"\"",
+        " \t\r\n[ ] ", "{}", "[[[]]]", "{\"a\":{\"b\":[1,2,{}]}}",
+        "\"\\u0041\\uD83D\\uDE0D\\/\\b\\f\\n\\r\\t\\\\\\\"\"",
+        "\"ASCII text that is long enough to be checked eight bytes at a time\"",
+        "\"\xC2\xA9 \xE2\x98\xA0 \xF0\x9F\x98\x8D\"",
+    };
+    const char* const invalid[] = {
+        "", " ", "+1", "01", "1.", ".5", "1e", "1e+", "-", "--1", "[1,]", "[,1]", "{\"a\":1,}",
+        "{\"a\"}", "{a:1}", "[1] x", "\v1", "[1 2]", "tru", "nul", "\"abc", "\"\x01\"",
+        "\"\\x\"", "\"\\u{41}\"", "\"\xC0\x80\"", "\"\xE0\x80\x80\"", "\"\xED\xA0\x80\"",
+        "\"\xF4\x90\x80\x80\"", "\"\xF8\x88\x80\x80\x80\"", "\"\x80\"",
+        "\"\xC2\"", "\"\xE2\x98\"", "\"\xC2" "A\"",
+        "\"ASCII text that is long enough to be checked eight bytes at a time\x7F\xFF\"",
+    };
+    bool success = true;
+    yajson::Value::ParseError error;
+    std::string deep(yajson::Parser::MaximumDepth + 1, '[');
+
+    for (const auto text : valid) {
+        if (!yajson::Value::validate(text) || !yajson::Value::validate(text, std::strlen(text))) {
+            printf("FAIL: valid %s\n", text);
+            success = false;
+        }
+    }
+
+    for (const auto text : invalid) {
+        if (yajson::Value::validate(text)) {
+            printf("FAIL: invalid %s\n", text);
+            success = false;
+        }
+    }
+
+    success = success && yajson::Value::validate(json);
+    success = success && !yajson::Value::validate("[1] x", &error);
+    success = success && error.code == yajson::Value::ParseError::UnexpectedCharacter;
+    success = success && error.offset == 4;
+    success = success && !yajson::Value::validate("\"\xED\xA0\x80\"", &error);
+    success = success && error.code == yajson::Value::ParseError::InvalidCodepoint;
+    success = success && !yajson::Value::validate("\"\\u{41}\"", &error); // parse accepts the ECMAScript form
+    success = success && error.code == yajson::Value::ParseError::InvalidEscape && error.offset == 3;
+    success = success && yajson::Value::parse("\"\\u{41}\"").string() == "A";
+    success = success && !yajson::Value::validate(deep, &error);
+    success = success && error.code == yajson::Value::ParseError::NestingTooDeep;
+    success = success && std::string(error.message()) == "Nesting too deep";
+    success = success && yajson::Value::validate(deep.substr(1) + std::string(deep.size() - 1, ']'));
+
+    for (const auto text : valid) {
+        success = success && yajson::Value::parse(text) == yajson::Value::parse(text);
+    }
+
+#ifndef YAJSON_NO_EXCEPTIONS
+    try {
+        yajson::Value::parse("[01]");
+        success = false;
+    } catch(const std::invalid_argument&) {}
+
+    try {
+        yajson::Value::parse("[1,]");
+        success = false;
+    } catch(const std::invalid_argument&) {}
+
+    try {
+        yajson::Value::parse("\"\xED\xA0\x80\"");
+        success = false;
+    } catch(const std::invalid_argument&) {}
+
+    try {
+        yajson::Value("truncated \xC2").format();
+        success = false;
+    } catch(const std::invalid_argument&) {}
+#endif
+
+    if (!success) {
+        printf("FAIL %s\n", __func__);
+    }
+
+    return success;
+}
+
+static bool testFormattedSize() {
+    bool success = true;
+    const auto j = yajson::Value::parse(json);
+    const yajson::Value values[] = {
+        j, yajson::Value(), yajson::Value::array(), yajson::Value::object(), yajson::Value(-42),
+        yajson::Value(2.5), yajson::Value(false), yajson::Value("\xE2\x98\xA0 \xF0\x9F\x98\x8D /"),
+    };
+
+    for (const auto& value : values) {
+        for (int indent = -1; indent < 4; ++indent) {
+            success = success && value.formattedSize(indent) == value.format(indent).size();
+            success = success && value.formattedSize(indent, 3) == value.format(indent, 3).size();
+        }
+    }
+
+    const auto text = j.format(2);
+    const auto size = j.formattedSize(2);
+    std::vector<char> buffer(size + 1, '*');
+
+    success = success && j.format(buffer.data(), size, 2) == size;
+    success = success && std::string(buffer.data(), size) == text;
+    success = success && buffer[size] == '*';
+
+    std::vector<char> small(10, '*');
+
+    success = success && j.format(small.data(), 5, 2) == size;
+    success = success && std::string(small.data(), 5) == text.substr(0, 5);
+    success = success && small[5] == '*';
+    success = success && yajson::Value().format(small.data(), small.size()) == 4;
+    success = success && std::string(small.data(), 4) == "null";
+
+    // sizes are counted without formatting, so check them against the text for awkward cases
+    const double reals[] = {
+        0.0, -0.0, 0.9999994, 0.9999995, 9.9999996, 99.99999949, -1e-9, 123456.5, -98765.4321, 4503599627370495.5,
+        1e15, 1e20, -1.7976931348623157e308, std::numeric_limits<double>::infinity(), std::nan(""),
+    };
+    auto numbers = yajson::Value::array();
+
+    for (const auto real : reals) {
+        numbers.append(real);
+    }
+
+    numbers.append(int64_t(-9223372036854775807LL - 1)).append(0).append(-7).append(int64_t(9223372036854775807LL));
+    numbers.append(yajson::Value::parse("[1.50, -0, 18446744073709551616]"));
+
+    const auto strings = yajson::Value::parse(R"(["", "plain", "\"\\\/\b\f\n\r\t", "\u0001\u001f\u007f",
+                                                  "é€😍", "a/b", {"kéy\n": " "}])");
+
+    for (const auto unicode : {yajson::Value::FormatOptions::EscapeBmp, yajson::Value::FormatOptions::RawUtf8,
+                               yajson::Value::FormatOptions::AsciiOnly}) {
+        for (const bool escapeSlash : {false, true}) {
+            yajson::Value::FormatOptions options(2);
+
+            options.unicode = unicode;
+            options.escapeSlash = escapeSlash;
+            success = success && numbers.formattedSize(options) == numbers.format(options).size();
+            success = success && strings.formattedSize(options) == strings.format(options).size();
+            success = success && strings.format(small.data(), 3, options) == strings.format(options).size();
+        }
+    }
+
+    std::string appended = "prefix:";
+    yajson::Output output(appended);
+
+    j["test\"me\""][2].format(output);
+    success = success && appended == "prefix:{\"go\\/now\":3}";
+    success = success && output.size() == appended.size() - 7;
+
+    if (!success) {
+        printf("FAIL %s\n", __func__);
+    }
+
+    return success;
+}
+
+static bool testFormatOptions() {
+    bool success = true;
+    const auto text = yajson::Value("a/b \xD0\x96 \xE2\x98\xA0 \xF0\x9F\x98\x8D \x01 \x7F");
+    yajson::Value::FormatOptions options;
+
+    success = success && text.format(options) == text.format();
+    success = success && text.format() == "\"a\\/b \\u0416 \\u2620 \xF0\x9F\x98\x8D \\u0001 \x7F\"";
+
+    options.escapeSlash = false;
+    options.unicode = yajson::Value::FormatOptions::RawUtf8;
+    success = success && text.format(options) == "\"a/b \xD0\x96 \xE2\x98\xA0 \xF0\x9F\x98\x8D \\u0001 \x7F\"";
+    success = success && text.formattedSize(options) == text.format(options).size();
+    success = success && yajson::Value("a long string with a / in the middle").format(options)
+                            == "\"a long string with a / in the middle\"";
+
+    options.unicode = yajson::Value::FormatOptions::AsciiOnly;
+    success = success && text.format(options) == "\"a/b \\u0416 \\u2620 \\ud83d\\ude0d \\u0001 \x7F\"";
+    success = success && yajson::Value::parse(text.format(options)) == text;
+    success = success && yajson::Value::parse("\"\\uD83D\\uDE0D\"").string() == "\xF0\x9F\x98\x8D";
+    success = success && yajson::Value::parse("\"\\uD83D\\u0041\"").string() == "\xED\xA0\xBD" "A";
+
+    const auto j = yajson::Value::object().set("\xEF\xBD\xA1", 1).set("\xF0\x9F\x98\x8D", 2).set("a", 3);
+
+    success = success && j.format() == "{\"a\":3,\"\\uff61\":1,\"\xF0\x9F\x98\x8D\":2}";
+    options = yajson::Value::FormatOptions(1);
+    options.indentCharacter = '\t';
+    options.keyOrder = yajson::Value::FormatOptions::Utf16Order;
+    options.unicode = yajson::Value::FormatOptions::RawUtf8;
+    success = success && j.format(options)
+                == "{\n\t\"a\":3,\n\t\"\xF0\x9F\x98\x8D\":2,\n\t\"\xEF\xBD\xA1\":1\n}";
+
+    const auto bmp = yajson::Value::object().set("\xEF\xBD\xA1", 1).set("\xC3\xA9", 2).set("b", 3);
+    auto byteOrder = options;
+
+    byteOrder.keyOrder = yajson::Value::FormatOptions::ByteOrder;
+    success = success && bmp.format(options) == bmp.format(byteOrder); // no 4-byte sequences, so no reordering
+
+    success = success && yajson::String::utf16Less("ab", "abc");
+    success = success && !yajson::String::utf16Less("abc", "ab");
+    success = success && yajson::String::utf16Less("\xF0\x9F\x98\x8D", "\xF0\x9F\x98\x8E");
+    success = success && yajson::String::utf16Less("\x80", "\x81");
+
+#ifndef YAJSON_NO_EXCEPTIONS
+    try {
+        yajson::Value::parse("\"\\uD83D\\u00\"");
+        success = false;
+    } catch(const std::invalid_argument&) {}
+#endif
+
+    options = yajson::Value::FormatOptions(80);
+    success = success && yajson::Value::array().append(1).format(options, 1)
+                == "[\n" + std::string(160, ' ') + "1\n" + std::string(80, ' ') + "]";
+
+    if (!success) {
+        printf("FAIL %s\n", __func__);
+    }
+
+    return success;
+}
+
+static bool testLazyNumbers() {
+    bool success = true;
+    const std::string text = "[1.50,-0,1E+2,9223372036854775808,-12,0.1e-999,1e999,3.0]";
+    const auto j = yajson::Value::parse(text);
+    const auto copy = j;
+
+    success = success && j.format() == text;
+    success = success && copy.format() == text;
+    success = success && j[0].is(yajson::Value::Real) && j[0].real() > 1.49 && j[0].real() < 1.51;
+    success = success && j[0] == yajson::Value(1.5);
+    success = success && yajson::Value(1.5) == j[0];
+    success = success && j[1].is(yajson::Value::Integer) && j[1].integer() == 0;
+    success = success && j[1] == yajson::Value(0);
+    success = success && j[2].is(yajson::Value::Real) && j[2] == yajson::Value(100.0);
+    success = success && j[3].is(yajson::Value::Integer);
+    success = success && j[3] == copy[3];
+    success = success && j[3] != j[4];
+    success = success && j[4] != j[3];
+    success = success && j[4] == yajson::Value(-12);
+    success = success && yajson::Value(-12) == j[4];
+    success = success && j[4] != yajson::Value(12);
+    success = success && j[5] != j[6];
+    success = success && j[7] == copy[7];
+    success = success && j[7] != j[0];
+    success = success && j[0] != yajson::Value(-12);
+    success = success && j == copy;
+    success = success && j == yajson::Value::parse(j.format());
+
+#ifndef YAJSON_NO_EXCEPTIONS
+    try {
+        j[0].integer();
+        success = false;
+    } catch(const std::domain_error&) {}
+
+    try {
+        j[1].real();
+        success = false;
+    } catch(const std::domain_error&) {}
+
+    try {
+        j[6].real();
+        success = false;
+    } catch(const std::invalid_argument&) {}
+#endif
+
+    auto counter = yajson::Value::parse("41");
+
+    counter += 1;
+    success = success && counter.format() == "42";
+
+    if (!success) {
+        printf("FAIL %s\n", __func__);
+    }
+
+    return success;
+}
+
+struct Address {
+    std::string city{};
+    int zip{};
+};
+
+struct Person {
+    std::string name{};
+    unsigned short age{};
+    int64_t id{};
+    double height{};
+    bool active{};
+    std::vector<std::string> tags{};
+    std::map<std::string, int> scores{};
+    Address home{};
+    std::vector<Address> previous{};
+    std::string nickname{};
+    yajson::Value extra{};
+};
+
+YAJSON_BIND(Address, YAJSON_FIELD(city), YAJSON_FIELD(zip))
+YAJSON_BIND(Person, YAJSON_FIELD(name), YAJSON_FIELD(age), YAJSON_FIELD_NAMED("person-id", id),
+            YAJSON_FIELD(height), YAJSON_FIELD(active), YAJSON_FIELD(tags), YAJSON_FIELD(scores),
+            YAJSON_FIELD(home), YAJSON_OPTIONAL(previous), YAJSON_OPTIONAL(nickname),
+            YAJSON_OPTIONAL(extra))
+
+static bool testBinding() {
+    bool success = true;
+    const std::string text = R"({"name": "Jörg", "age": 42, "person-id": -9007199254740993,
+        "height": 1.8e0, "active": true, "tags": ["a", "b"], "scores": {"x": 1, "y": -2},
+        "unknown": {"deep": [1, {"a": null}]}, "home": {"zip": 12345, "city": "Here"},
+        "previous": [{"city": "There", "zip": 1}], "nickname": null, "extra": [1, "two"]})";
+    Person person;
+    yajson::Value::ParseError error;
+    size_t offset = 0;
+
+    person.nickname = "unchanged";
+    yajson::Binding::parse(text, person, &offset);
+    success = success && offset == text.size();
+    success = success && person.name == "J\xC3\xB6rg";
+    success = success && person.age == 42;
+    success = success && person.id == -9007199254740993LL;
+    success = success && person.height > 1.79 && person.height < 1.81;
+    success = success && person.active;
+    success = success && person.tags.size() == 2 && person.tags[1] == "b";
+    success = success && person.scores.size() == 2 && person.scores["y"] == -2;
+    success = success && person.home.city == "Here" && person.home.zip == 12345;
+    success = success && person.previous.size() == 1 && person.previous[0].city == "There";
+    success = success && person.nickname == "unchanged";
+    success = success && person.extra == yajson::Value::parse("[1,\"two\"]");
+
+    Address address;
+
+    success = success && yajson::Binding::tryParse("{\"city\":\"A\",\"zip\":1}", address, error);
+    success = success && error.code == yajson::Value::ParseError::None;
+
+    const struct {
+        const char* text;
+        yajson::Value::ParseError::Code code;
+        size_t offset;
+    } failures[] = {
+        {"{\"city\":\"A\"}", yajson::Value::ParseError::MissingField, 12},
+        {"{\"city\":\"A\",\"zip\":1.5}", yajson::Value::ParseError::TypeMismatch, 18},
+        {"{\"city\":\"A\",\"zip\":\"1\"}", yajson::Value::ParseError::TypeMismatch, 18},
+        {"{\"city\":7,\"zip\":1}", yajson::Value::ParseError::TypeMismatch, 8},
+        {"{\"city\":\"A\",\"zip\":3000000000}", yajson::Value::ParseError::InvalidNumber, 18},
+        {"{\"city\":\"A\",\"zip\":null}", yajson::Value::ParseError::TypeMismatch, 18},
+        {"{\"city\":\"A\",\"zip\":01}", yajson::Value::ParseError::UnexpectedCharacter, 19},
+        {"{\"city\":\"A\",\"zip\":1", yajson::Value::ParseError::UnexpectedEnd, 19},
+        {"{\"city\":\"A\",\"zip\":", yajson::Value::ParseError::UnexpectedEnd, 18},
+        {"[]", yajson::Value::ParseError::TypeMismatch, 0},
+    };
+
+    for (auto& failure : failures) {
+        const bool parsed = yajson::Binding::tryParse(failure.text, address, error);
+
+        if (parsed || (error.code != failure.code) || (error.offset != failure.offset)) {
+            printf("FAIL: %s code %d offset %d\n", failure.text, int(error.code), int(error.offset));
+            success = false;
+        }
+    }
+
+    const std::string partial = "{\"name\":\"x\",\"age\":-1";
+    std::vector<unsigned> numbers;
+    std::map<std::string, bool> flags;
+
+    success = success && !yajson::Binding::tryParse(partial, person, error);
+    success = success && error.code == yajson::Value::ParseError::InvalidNumber;
+    success = success && yajson::Binding::tryParse("[0, -0, 4294967295]", numbers, error);
+    success = success && numbers.size() == 3 && numbers[2] == 4294967295U;
+    success = success && !yajson::Binding::tryParse("[4294967296]", numbers, error);
+    success = success && yajson::Binding::tryParse(" {\"a\": true, \"b\": false} ", flags, error);
+    success = success && flags.size() == 2 && flags["a"] && !flags["b"];
+    success = success && !yajson::Binding::tryParse("{\"a\": 1}", flags, error);
+
+#ifndef YAJSON_NO_EXCEPTIONS
+    try {
+        yajson::Binding::parse("{\"city\":\"A\"}", address);
+        success = false;
+    } catch(const std::invalid_argument&) {}
+#endif
+
+    if (!success) {
+        printf("FAIL %s\n", __func__);
+    }
+
+    return success;
+}
+
+static bool testBindingFormat() {
+    bool success = true;
+    Person person;
+    std::map<std::string, std::vector<Address>> places;
+
+    person.name = "a\"b/\xE2\x98\xA0";
+    person.age = 65535;
+    person.id = -1;
+    person.height = 0.5;
+    person.tags = {"x", "y"};
+    person.scores["z"] = 3;
+    person.home.city = "Here";
+    person.previous.resize(2);
+    person.extra = yajson::Value::array().append(true);
+    places["\xEF\xBD\xA1"] = person.previous;
+    places["\xF0\x9F\x98\x8D"] = {};
+    places["a"] = {person.home};
+
+    const auto text = yajson::Binding::format(person);
+
+    success = success && text == "{\"active\":false,\"age\":65535,\"extra\":[true],\"height\":0.500000,"
+                                 "\"home\":{\"city\":\"Here\",\"zip\":0},\"name\":\"a\\\"b\\/\\u2620\","
+                                 "\"person-id\":-1,\"previous\":[{\"city\":\"\",\"zip\":0},{\"city\":\"\",\"zip\":0}],"
+                                 "\"scores\":{\"z\":3},\"tags\":[\"x\",\"y\"]}";
+
+    Person copy;
+
+    yajson::Binding::parse(text, copy);
+    success = success && yajson::Binding::format(copy) == text;
+    copy.nickname = "n";
+    copy.previous.clear();
+    copy.extra = yajson::Value();
+    success = success && yajson::Binding::format(copy).find("\"extra\"") == std::string::npos;
+    success = success && yajson::Binding::format(copy).find("\"previous\"") == std::string::npos;
+    success = success && yajson::Binding::format(copy).find("\"nickname\":\"n\",\"person-id\"") != std::string::npos;
+
+    for (int indent = -1; indent < 4; ++indent) {
+        yajson::Value::FormatOptions options(indent);
+
+        options.unicode = yajson::Value::FormatOptions::RawUtf8;
+        options.escapeSlash = false;
+        options.indentCharacter = (indent == 3) ? '\t' : ' ';
+
+        for (int order = 0; order < 2; ++order) {
+            options.keyOrder = order == 0 ? yajson::Value::FormatOptions::ByteOrder
+                                          : yajson::Value::FormatOptions::Utf16Order;
+
+            const auto bound = yajson::Binding::format(places, options, 1);
+
+            success = success && yajson::Binding::format(person, options, 1)
+                                    == yajson::Value::parse(text).format(options, 1);
+
+            success = success && bound == yajson::Value::parse(bound).format(options, 1);
+            success = success && yajson::Binding::format(person.tags, options)
+                                    == yajson::Value::parse("[\"x\",\"y\"]").format(options);
+        }
+    }
+
+    char buffer[8];
+    yajson::Output output(buffer, sizeof(buffer));
+
+    yajson::Binding::format(output, std::vector<uint64_t>{18446744073709551615ULL, 0});
+    success = success && output.size() == 24 && std::string(buffer, sizeof(buffer)) == "[1844674";
+
+    if (!success) {
+        printf("FAIL %s\n", __func__);
+    }
+
+    return success;
+}
+
+static bool testWriter() {
+    bool success = true;
+    const auto expected = yajson::Value::parse(
+        R"({"a/b": [1, -2, 18446744073709551615, 0.500000, true, false, null, "x☠", {"c": []}],
+            "empty": {}, "value": {"k": [1]}, "raw": [1,2], "bound": {"city": "Here", "zip": 7}})");
+
+    for (int indent = -1; indent < 3; ++indent) {
+        std::string text;
+        yajson::StringSink sink(text);
+        yajson::Writer writer(sink, indent);
+        Address address;
+
+        address.city = "Here";
+        address.zip = 7;
+        writer.beginObject().key("a/b").beginArray();
+        writer.value(1).value(int64_t(-2)).value(uint64_t(18446744073709551615ULL)).value(0.5);
+        writer.value(true).value(false).null().value("x\xE2\x98\xA0");
+        writer.beginObject().key(std::string("c")).beginArray().endArray().endObject();
+        writer.endArray();
+        writer.key("bound").bound(address);
+        writer.key("empty").beginObject().endObject();
+        writer.key("raw").raw(indent < 0 ? "[1,2]" : yajson::Value::parse("[1,2]").format(indent, 1));
+        writer.key("value").value(yajson::Value::object().set("k", yajson::Value::array().append(1)));
+        success = success && !writer.complete() && text.empty();
+        writer.endObject();
+        success = success && writer.complete() && writer.size() == text.size();
+        success = success && text == expected.format(indent);
+    }
+
+    std::string text;
+    yajson::StringSink sink(text);
+    yajson::Writer writer(sink, 2);
+
+    writer.beginArray().value(yajson::Value::array().append(1)).value("s").endArray();
+    success = success && text == yajson::Value::parse(text).format(2);
+
+    std::ostringstream stream;
+    yajson::StreamSink streamSink(stream);
+    size_t chunks = 0;
+    size_t largest = 0;
+    yajson::CallbackSink callback([&stream, &chunks, &largest](const char* data, size_t size) {
+        stream.write(data, static_cast<std::streamsize>(size));
+        chunks += 1;
+        largest = std::max(largest, size);
+    });
+    yajson::Writer big(callback, yajson::Value::FormatOptions(yajson::Writer::BufferSize + 1));
+    const std::string longString(yajson::Writer::BufferSize * 2, 'x');
+
+    big.beginArray();
+
+    for (int i = 0; i < 3000; ++i) {
+        big.value(i);
+    }
+
+    big.value(longString).endArray();
+    success = success && chunks > 3 && largest >= longString.size();
+    success = success && yajson::Value::parse(stream.str()).count() == 3001;
+    success = success && stream.str().size() == big.size();
+    stream.str("");
+    yajson::Writer(streamSink).beginArray().value(1).endArray();
+    success = success && stream.str() == "[1]";
+    stream.str("");
+    yajson::Writer(streamSink).beginArray().value(static_cast<const char*>(nullptr)).value(2);
+    success = success && stream.str() == "[null,2";
+
+    int pipe[2];
+
+    if (::pipe(pipe) == 0) {
+        yajson::FileSink fileSink(pipe[1]);
+        char buffer[16] = {};
+
+        yajson::Writer(fileSink).beginObject().key("a").value(1).endObject();
+        ::close(pipe[1]);
+        success = success && ::read(pipe[0], buffer, sizeof(buffer) - 1) == 7;
+        success = success && std::string(buffer) == "{\"a\":1}";
+        ::close(pipe[0]);
+
+#ifndef YAJSON_NO_EXCEPTIONS
+        try {
+            yajson::FileSink(pipe[1]).write("x", 1);
+            success = false;
+        } catch(const std::runtime_error&) {}
+#endif
+    }
+
+#ifndef YAJSON_NO_EXCEPTIONS
+    const std::function<void(yajson::Writer&)> misuse[] = {
+        [](yajson::Writer& w) {w.endArray();},
+        [](yajson::Writer& w) {w.key("a");},
+        [](yajson::Writer& w) {w.beginArray().key("a");},
+        [](yajson::Writer& w) {w.beginArray().endObject();},
+        [](yajson::Writer& w) {w.beginObject().value(1);},
+        [](yajson::Writer& w) {w.beginObject().key("a").key("b");},
+        [](yajson::Writer& w) {w.beginObject().key("a").endObject();},
+        [](yajson::Writer& w) {w.value(1).value(2);},
+    };
+
+    for (auto& test : misuse) {
+        std::string ignored;
+        yajson::StringSink ignoredSink(ignored);
+        yajson::Writer w(ignoredSink);
+
+        try {
+            test(w);
+            success = false;
+        } catch(const std::invalid_argument&) {}
+    }
+#endif
+
+    if (!success) {
+        printf("FAIL %s\n", __func__);
+    }
+
+    return success;
+}
+
+static bool testParseInto() {
+    bool success = true;
+    const std::string first = R"({"list": [1, 2, 3, "a string too long for small string storage"],
+        "nested": {"x": true, "y": null}, "gone": 1, "name": "another string too long for the buffer"})";
+    const std::string second = R"( {"list": [4, -5.5], "nested": {"y": false, "z": [1]},
+        "name": "short", "name": "duplicate", "new": "value"} )";
+    yajson::Value value;
+    yajson::Value::ParseError error;
+    size_t offset = 0;
+
+    yajson::Value::parseInto(first, value);
+    success = success && value == yajson::Value::parse(first);
+
+    const auto slot = &value["list"][0];
+    const auto node = &value["nested"];
+
+    success = success && yajson::Value::tryParseInto(second, value, error, &offset);
+    success = success && offset == second.size() - 1;
+    success = success && value == yajson::Value::parse(second);
+    success = success && value.format() == yajson::Value::parse(second).format();
+    success = success && !value.has("gone") && !value["nested"].has("x");
+    success = success && value["name"].string() == "duplicate";
+    success = success && &value["list"][0] == slot && &value["nested"] == node;
+
+    yajson::Value::parseInto(second, value);
+    success = success && value == yajson::Value::parse(second) && &value["list"][0] == slot;
+    success = success && yajson::Value::parseInto("[{\"a\":1}]", value) == yajson::Value::parse("[{\"a\":1}]");
+    success = success && yajson::Value::parseInto("[true,\"a\",{}]", value).format() == "[true,\"a\",{}]";
+    success = success && yajson::Value::parseInto("[false,2,{\"b\":[]}]", value).format() == "[false,2,{\"b\":[]}]";
+    const std::string longKeys = R"({"a key beyond small string storage": {"a nested key beyond that storage": 1},
+        "another key beyond small string storage": 2})";
+
+    yajson::Value::parseInto(longKeys, value);
+    success = success && yajson::Value::parseInto(longKeys, value) == yajson::Value::parse(longKeys);
+    success = success && !yajson::Value::tryParseInto("{\"a\":[1,}", value, error);
+    success = success && value.isNull() && error.code == yajson::Value::ParseError::UnexpectedCharacter;
+    success = success && !yajson::Value::tryParseInto("  ", value, error);
+    success = success && error.code == yajson::Value::ParseError::UnexpectedEnd;
+
+    value = yajson::Value::parse("{\"a\":{\"b\":1}}");
+
+#ifndef YAJSON_NO_EXCEPTIONS
+    try {
+        yajson::Value::parseInto("{\"a\":{\"b\":}}", value);
+        success = false;
+    } catch(const std::invalid_argument&) {}
+#endif
+
+    if (!success) {
+        printf("FAIL %s\n", __func__);
+    }
+
+    return success;
+}
+
+static bool testNonThrowingAccessors() {
+    bool success = true;
+    const auto j = yajson::Value::parse(
+        R"({"i": 42, "r": 1.5, "b": true, "s": "text", "n": null, "a": [1], "big": 9223372036854775808})");
+    const std::string fallback = "fallback";
+    bool boolean = false;
+    int64_t integer = 7;
+    double real = 0.0;
+    std::string text;
+
+    success = success && j["i"].tryInteger(integer) && integer == 42;
+    success = success && !j["r"].tryInteger(integer) && integer == 42;
+    success = success && !j["big"].tryInteger(integer) && integer == 42;
+    success = success && !j["n"].tryInteger(integer) && !j.tryInteger(integer);
+    success = success && j["r"].tryReal(real) && real > 1.49 && real < 1.51;
+    success = success && !j["i"].tryReal(real);
+    success = success && yajson::Value(2.5).tryReal(real) && real > 2.49 && real < 2.51;
+    success = success && yajson::Value(3).tryInteger(integer) && integer == 3;
+    success = success && j["b"].tryBoolean(boolean) && boolean;
+    success = success && !j["i"].tryBoolean(boolean) && !j["n"].tryBoolean(boolean);
+    success = success && j["s"].tryString(text) && text == "text";
+    success = success && !j["i"].tryString(text) && text == "text";
+    success = success && j["s"].stringRef() == "text" && &j["s"].stringRef() == &j["s"].stringRef();
+    success = success && j["n"].stringRef().empty();
+
+    success = success && j["i"].asInteger(-1) == 42 && j["s"].asInteger(-1) == -1;
+    success = success && j["r"].asReal(-1.0) > 1.0 && j["a"].asReal(-1.0) < 0.0;
+    success = success && j["b"].asBoolean(false) && !j["i"].asBoolean(false);
+    success = success && &j["s"].asString(fallback) != &fallback;
+    success = success && &j["i"].asString(fallback) == &fallback;
+    success = success && std::string(j["s"].asString("x")) == "text";
+    success = success && std::string(j["n"].asString("x")) == "x";
+
+    success = success && j.getOr("i", 0) == 42 && j.getOr("missing", 5) == 5;
+    success = success && j.getOr("i", int64_t(0)) == 42 && j.getOr("r", int64_t(3)) == 3;
+    success = success && j.getOr("r", 0.0) > 1.0 && j.getOr("missing", 2.0) > 1.0;
+    success = success && j.getOr("b", false) && j.getOr("missing", true) && !j.getOr("s", false);
+    success = success && &j.getOr("missing", fallback) == &fallback;
+    success = success && j.getOr("s", fallback) == "text";
+    success = success && std::string(j.getOr("s", "x")) == "text";
+    success = success && std::string(j.getOr("a", "x")) == "x";
+    success = success && j["a"].getOr("i", 9) == 9 && yajson::Value().getOr("i", 9) == 9;
+
+#ifndef YAJSON_NO_EXCEPTIONS
+    try {
+        j["i"].stringRef();
+        success = false;
+    } catch(const std::domain_error&) {}
+#endif
+
+#if __cplusplus >= 201703L
+    success = success && j["s"].stringView() == "text";
+#endif
+
+    if (!success) {
+        printf("FAIL %s\n", __func__);
+    }
+
+    return success;
+}
+
+static bool testKeyLookup() {
+    bool success = true;
+    auto j = yajson::Value::parse(R"({"id": 1, "ident": 2, "i": 3, "é": 4, "": 5})");
+    const char buffer[] = {'i', 'd', 'e', 'n', 't', 'x'};
+    const yajson::Key ident(buffer, 5);
+    const yajson::Key id("id");
+
+    success = success && id.size() == 2 && ident.string() == "ident";
+    success = success && j[id].integer() == 1 && j[ident].integer() == 2;
+    success = success && j.has(yajson::Key(buffer, 1)) && !j.has(yajson::Key(buffer, 3));
+    success = success && j.find(yajson::Key(buffer, 0))->integer() == 5;
+    success = success && j.at("\xC3\xA9").integer() == 4 && j.getOr(ident, 0) == 2;
+    success = success && j.get(std::string("i")).integer() == 3;
+    success = success && id.compare("i") > 0 && id.compare("ident") < 0 && id.compare("id") == 0;
+    success = success && yajson::Key("\xC3\xA9").compare("z") > 0;
+
+    j.set(yajson::Key(buffer, 6), 6).erase(id);
+    j[yajson::Key(buffer, 4)] = 7;
+    success = success && j.format() == R"({"":5,"i":3,"iden":7,"ident":2,"identx":6,"\u00e9":4})";
+    success = success && yajson::Value(j)[ident].integer() == 2;
+
+#ifndef YAJSON_NO_EXCEPTIONS
+    try {
+        j.at(yajson::Key(buffer, 2));
+        success = false;
+    } catch(const std::out_of_range&) {}
+#endif
+
+#if __cplusplus >= 201703L
+    const std::string_view view("identx", 5);
+
+    success = success && j[view].integer() == 2 && j.has(view);
+#endif
+
+    if (!success) {
+        printf("FAIL %s\n", __func__);
+    }
+
+    return success;
+}
+
+static bool testHash() {
+    bool success = true;
+    const auto a = yajson::Value::parse(R"({"b": [1, 2.50, "x", true, null], "a": {"c": -0, "d": 1E2}})");
+    const auto b = yajson::Value::parse(R"({"a": {"d": 100.0, "c": 0}, "b": [1, 2.5, "x", true, null]})");
+    const auto c = yajson::Value::parse(R"({"a": {"d": 100.0, "c": 0}, "b": [1, 2.5, "x", false, null]})");
+    const auto big = yajson::Value::parse("[9223372036854775808, 1e999]");
+    std::unordered_set<yajson::Value> unique;
+
+    success = success && a == b && b == a && a.hash() == b.hash();
+    success = success && a != c && c != a && a.hash() != c.hash();
+    success = success && yajson::Value(0.0) == yajson::Value(0.0);
+    success = success && yajson::Value(-0.0) == yajson::Value(0.0);
+    success = success && yajson::Value(-0.0).hash() == yajson::Value(0.0).hash();
+    success = success && yajson::Value(std::nan("")) == yajson::Value(std::nan("1"));
+    success = success && yajson::Value(std::nan("")).hash() == yajson::Value(std::nan("1")).hash();
+    success = success && yajson::Value(std::nan("")) != yajson::Value(1.0);
+    success = success && yajson::Value(0.1 + 0.2) != yajson::Value(0.3);
+    success = success && yajson::Value(1) != yajson::Value(1.0);
+    success = success && yajson::Value::parse("12").hash() == yajson::Value(12).hash();
+    success = success && yajson::Value::parse("1.5").hash() == yajson::Value(1.5).hash();
+    success = success && big == yajson::Value::parse(big.format()) && big.hash() == yajson::Value(big).hash();
+    success = success && yajson::Value().hash() == yajson::Value::null().hash();
+    success = success && yajson::Value("1").hash() != yajson::Value(1).hash();
+    success = success && yajson::Value::array().hash() != yajson::Value::object().hash();
+
+    unique.insert(a);
+    unique.insert(b);
+    unique.insert(c);
+    unique.insert(yajson::Value());
+    success = success && unique.size() == 3 && unique.count(yajson::Value::parse(b.format())) == 1;
+
+    if (!success) {
+        printf("FAIL %s\n", __func__);
+    }
+
+    return success;
+}
+
+static bool testBinary() {
+    bool success = true;
+    const auto sample = yajson::Value::parse(R"({"a": 1, "b": [true, null, -1, 300, 1.5]})");
+    const std::string packed("\x82\xA1" "a" "\x01\xA1" "b" "\x95\xC3\xC0\xFF\xCD\x01\x2C\xCB\x3F\xF8\0\0\0\0\0\0", 22);
+    const std::string cbor("\xA2\x61" "a" "\x01\x61" "b" "\x85\xF5\xF6\x20\x19\x01\x2C\xFB\x3F\xF8\0\0\0\0\0\0", 22);
+    const auto mixed = yajson::Value::parse(R"({"int": 3, "real": 3.0, "neg": -200000, "min": -9223372036854775808,
+                                               "text": "héllo 😀", "nested": {"list": [[], {}, 0.25]}})");
+    const std::string wideUnsigned("\xCF\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF", 9);
+    const std::string wideNegative("\x3B\x80\0\0\0\0\0\0\0", 9);
+    yajson::Value value;
+    yajson::Value::ParseError error;
+    size_t offset = 0;
+
+    success = success && yajson::Binary::encode(sample, yajson::Binary::MessagePack) == packed;
+    success = success && yajson::Binary::encode(sample, yajson::Binary::Cbor) == cbor;
+    success = success && yajson::Binary::decode(packed, yajson::Binary::MessagePack) == sample;
+    success = success && yajson::Binary::decode(cbor, yajson::Binary::Cbor) == sample;
+
+    for (auto format : {yajson::Binary::MessagePack, yajson::Binary::Cbor}) {
+        const auto decoded = yajson::Binary::decode(yajson::Binary::encode(mixed, format), format);
+        const std::string longText(70000, 'x');
+
+        success = success && decoded == mixed && decoded["real"].is(yajson::Value::Real);
+        success = success && decoded["int"].is(yajson::Value::Integer);
+        success = success && yajson::Binary::decode(yajson::Binary::encode(longText, format), format) == longText;
+        success = success && yajson::Binary::encode(yajson::Value::parse("18446744073709551615"), format).size() == 9;
+    }
+
+    value = yajson::Binary::decode(wideUnsigned, yajson::Binary::MessagePack);
+    success = success && value.format() == "18446744073709551615";
+    success = success && yajson::Binary::encode(value, yajson::Binary::MessagePack) == wideUnsigned;
+    value = yajson::Binary::decode(wideNegative, yajson::Binary::Cbor);
+    success = success && value.format() == "-9223372036854775809";
+    success = success && yajson::Binary::encode(value, yajson::Binary::Cbor) == wideNegative;
+    success = success && yajson::Binary::decode("\xD0\x80", yajson::Binary::MessagePack) == yajson::Value(-128);
+    success = success && yajson::Binary::decode("\xD1\xFF\x7F", yajson::Binary::MessagePack) == yajson::Value(-129);
+    success = success && yajson::Binary::decode(std::string("\xCA\x3F\xC0\0\0", 5), yajson::Binary::MessagePack) == yajson::Value(1.5);
+
+    // half precision, indefinite lengths, tags and undefined
+    success = success && yajson::Binary::decode(std::string("\xF9\x3C\0", 3), yajson::Binary::Cbor) == yajson::Value(1.0);
+    success = success && yajson::Binary::decode(std::string("\xF9\xC4\0", 3), yajson::Binary::Cbor) == yajson::Value(-4.0);
+    success = success && yajson::Binary::decode(std::string("\xF9\0\x01", 3), yajson::Binary::Cbor).real() > 5.9e-8;
+    success = success && std::isinf(yajson::Binary::decode(std::string("\xF9\x7C\0", 3), yajson::Binary::Cbor).real());
+    success = success && yajson::Binary::decode("\x9F\x01\x82\x02\x03\xFF", yajson::Binary::Cbor).format() == "[1,[2,3]]";
+    success = success && yajson::Binary::decode("\xBF\x7F\x61" "a" "\x61" "b" "\xFF\x01\xFF", yajson::Binary::Cbor).format()
+                            == "{\"ab\":1}";
+    success = success && yajson::Binary::decode("\xC1\x1A\x51\x4B\x67\xB0", yajson::Binary::Cbor) == yajson::Value(1363896240);
+    success = success && yajson::Binary::decode("\xF7", yajson::Binary::Cbor).isNull();
+
+    offset = 0;
+    success = success && yajson::Binary::tryDecode("\x01\x02", 2, yajson::Binary::Cbor, value, error, &offset);
+    success = success && offset == 1 && value == yajson::Value(1);
+    success = success && yajson::Binary::tryDecode("\x01\x02", 2, yajson::Binary::Cbor, value, error, &offset);
+    success = success && offset == 2 && value == yajson::Value(2);
+
+    // errors leave the value untouched and report where decoding stopped
+    const struct {
+        yajson::Binary::Format format;
+        std::string data;
+        yajson::Value::ParseError::Code code;
+        size_t offset;
+    } failures[] = {
+        {yajson::Binary::MessagePack, "", yajson::Value::ParseError::UnexpectedEnd, 0},
+        {yajson::Binary::MessagePack, "\xC1", yajson::Value::ParseError::UnexpectedCharacter, 0},
+        {yajson::Binary::MessagePack, "\x91\xC4", yajson::Value::ParseError::TypeMismatch, 1},
+        {yajson::Binary::MessagePack, "\xCD\x01", yajson::Value::ParseError::UnexpectedEnd, 2},
+        {yajson::Binary::MessagePack, "\xA1\xFF", yajson::Value::ParseError::InvalidCodepoint, 1},
+        {yajson::Binary::MessagePack, "\x81\x01\x01", yajson::Value::ParseError::TypeMismatch, 1},
+        {yajson::Binary::MessagePack, std::string(2000, '\x91'), yajson::Value::ParseError::NestingTooDeep, 1024},
+        {yajson::Binary::Cbor, "\x41" "a", yajson::Value::ParseError::TypeMismatch, 0},
+        {yajson::Binary::Cbor, "\xFF", yajson::Value::ParseError::UnexpectedCharacter, 0},
+        {yajson::Binary::Cbor, "\x1C", yajson::Value::ParseError::UnexpectedCharacter, 0},
+        {yajson::Binary::Cbor, "\x62\xED\xA0", yajson::Value::ParseError::InvalidCodepoint, 1},
+        {yajson::Binary::Cbor, "\xA1\x01\x01", yajson::Value::ParseError::TypeMismatch, 1},
+        {yajson::Binary::Cbor, "\x9F\x01", yajson::Value::ParseError::UnexpectedEnd, 2},
+        {yajson::Binary::Cbor, std::string(2000, '\x81'), yajson::Value::ParseError::NestingTooDeep, 1024},
+    };
+
+    for (const auto& failure : failures) {
+        value = yajson::Value("unchanged");
+        success = success && !yajson::Binary::tryDecode(failure.data, failure.format, value, error);
+        success = success && error.code == failure.code && error.offset == failure.offset;
+        success = success && value == yajson::Value("unchanged");
+    }
+
+#ifndef YAJSON_NO_EXCEPTIONS
+    try {
+        yajson::Binary::decode("\xC1", yajson::Binary::MessagePack);
+        success = false;
+    } catch(const std::invalid_argument&) {}
+
+    try {
+        yajson::Binary::encode(yajson::Value::parse("-9223372036854775809"), yajson::Binary::MessagePack);
+        success = false;
+    } catch(const std::out_of_range&) {}
+#endif
+
+    if (!success) {
+        printf("FAIL %s\n", __func__);
+    }
+
+    return success;
+}
+
+static bool testSnapshot() {
+    bool success = true;
+    const auto document = yajson::Value::parse(R"({"name": "reference", "count": 3, "ratio": 0.25, "on": true,
+                                                  "off": false, "none": null, "big": 18446744073709551615,
+                                                  "rows": [{"id": 1, "tag": "a"}, {"id": 2, "tag": "a"}, [], {}],
+                                                  "text": "héllo"})");
+    const auto snapshot = yajson::Snapshot::write(document);
+    const yajson::SnapshotView view(snapshot.data(), snapshot.size());
+    const yajson::SnapshotView missing;
+
+    success = success && view.is(yajson::Value::Object) && view.count() == 9;
+    success = success && view["name"].string() == "reference" && view.at("count").integer() == 3;
+    success = success && view["ratio"].value() == yajson::Value(0.25) && view["on"].boolean() && !view["off"].boolean();
+    success = success && view.has("none") && view["none"].isNull() && !view.has("nothing");
+    success = success && view["nothing"].isNull() && missing.isNull() && missing.count() == 0;
+    success = success && view["big"].is(yajson::Value::Integer) && view["big"].value().format() == "18446744073709551615";
+    success = success && view["rows"].count() == 4 && view["rows"][1]["id"].integer() == 2;
+    success = success && view["rows"][1]["tag"].stringSize() == 1 && view["rows"][1]["tag"].stringData()[1] == '\0';
+    success = success && view["rows"][2].is(yajson::Value::Array) && view["rows"][3].count() == 0;
+    success = success && view["rows"][9].isNull() && view["text"].string() == "h\xC3\xA9llo";
+    success = success && view.keys() == document.keys() && view.key(0).compare("big") == 0;
+    success = success && view.member(0).value() == document["big"];
+    success = success && view.value() == document;
+    success = success && yajson::SnapshotView(snapshot.data(), snapshot.size())["rows"].value() == document["rows"];
+
+    // equal keys and strings are stored once
+    success = success && snapshot.find("tag") == snapshot.rfind("tag");
+
+#ifndef YAJSON_NO_EXCEPTIONS
+    try {
+        view.at("nothing");
+        success = false;
+    } catch(const std::out_of_range&) {}
+
+    try {
+        view["rows"].at(4);
+        success = false;
+    } catch(const std::out_of_range&) {}
+
+    try {
+        view["name"].integer();
+        success = false;
+    } catch(const std::domain_error&) {}
+
+    try {
+        view["none"]["key"];
+        success = false;
+    } catch(const std::domain_error&) {}
+
+    const std::string invalid[] = {
+        "", "YJSN", std::string("JSON\x01\0\0\0\0\0\0\0\0\0\0\0\0", 17), std::string("YJSN\x02\0\0\0\0\0\0\0\0\0\0\0\0", 17),
+    };
+
+    for (const auto& data : invalid) {
+        try {
+            yajson::SnapshotView(data.data(), data.size());
+            success = false;
+        } catch(const std::invalid_argument&) {}
+    }
+#endif
+
+    // an array whose record points back at itself
+    std::string cycle = yajson::Snapshot::write(yajson::Value::parse("[[1]]"));
+
+    cycle[18] = '\x11';
+
+#ifndef YAJSON_NO_EXCEPTIONS
+    try {
+        yajson::SnapshotView(cycle.data(), cycle.size())[0].value();
+        success = false;
+    } catch(const std::invalid_argument&) {}
+#endif
+
+    char path[] = "/tmp/yajson_snapshot_XXXXXX";
+    const int descriptor = ::mkstemp(path);
+
+    if (descriptor >= 0) {
+        yajson::FileSink file(descriptor);
+
+        yajson::Snapshot::write(file, document);
+        ::close(descriptor);
+
+        const yajson::MappedFile mapped(path);
+
+        success = success && mapped.size() == snapshot.size();
+        success = success && mapped.snapshot()["rows"][0]["tag"].string() == "a";
+        success = success && mapped.snapshot().value() == document;
+        ::unlink(path);
+    }
+
+#ifndef YAJSON_NO_EXCEPTIONS
+    try {
+        yajson::MappedFile("/nonexistent/yajson.snapshot");
+        success = false;
+    } catch(const std::runtime_error&) {}
+
+    // a slot of [\"abc\", [1]] or its string made to point outside the buffer, back, or past the end
+    const std::string nested = yajson::Snapshot::write(yajson::Value::parse("[\"abc\", [1]]"));
+    const struct {
+        size_t position;
+        char byte;
+    } corruptions[] = {{17, '\x0F'}, {18, '\xFF'}, {22, '\x0D'}, {27, '\xF0'}, {27, '\x11'}, {31, '\x02'}};
+
+    for (const auto& corruption : corruptions) {
+        std::string data = nested;
+
+        data[corruption.position] = corruption.byte;
+
+        try {
+            yajson::SnapshotView(data.data(), data.size()).value();
+            success = false;
+        } catch(const std::invalid_argument&) {}
+    }
+
+    std::string unknownTag = nested;
+
+    unknownTag[17] = '\x0F';
+
+    try {
+        yajson::SnapshotView(unknownTag.data(), unknownTag.size())[0].getType();
+        success = false;
+    } catch(const std::invalid_argument&) {}
+
+    for (size_t size = 17; size < snapshot.size(); ++size) { // from a bare root slot to one byte short
+        try {
+            yajson::SnapshotView(snapshot.data(), size).value();
+            success = false;
+        } catch(const std::invalid_argument&) {}
+    }
+
+    char directory[] = "/tmp/yajson_directory_XXXXXX";
+
+    if (nullptr != ::mkdtemp(directory)) {
+        try {
+            yajson::MappedFile mapped(directory); // opens and stats, but a directory cannot be mapped
+            success = success && mapped.size() == 0;
+        } catch(const std::runtime_error&) {}
+
+        ::rmdir(directory);
+    }
+
+    char empty[] = "/tmp/yajson_empty_XXXXXX";
+    const int emptyDescriptor = ::mkstemp(empty);
+
+    if (emptyDescriptor >= 0) {
+        ::close(emptyDescriptor);
+
+        const yajson::MappedFile mapped(empty);
+
+        success = success && mapped.size() == 0 && nullptr == mapped.data();
+
+        try {
+            mapped.snapshot();
+            success = false;
+        } catch(const std::invalid_argument&) {}
+
+        ::unlink(empty);
+    }
+#endif
+
+    if (!success) {
+        printf("FAIL %s\n", __func__);
+    }
+
+    return success;
+}
+
+static bool testPatch() {
+    bool success = true;
+    auto document = yajson::Value::parse(R"({"a/b": {"c~d": [1, 2, 3]}, "name": "long enough to allocate", "list": [0]})");
+    const auto original = document;
+    const struct {
+        const char* document;
+        const char* patch;
+        const char* expected;
+    } rfc6902[] = {
+        {R"({"foo": "bar"})", R"([{"op": "add", "path": "/baz", "value": "qux"}])", R"({"baz": "qux", "foo": "bar"})"},
+        {R"({"foo": ["bar", "baz"]})", R"([{"op": "add", "path": "/foo/1", "value": "qux"}])",
+            R"({"foo": ["bar", "qux", "baz"]})"},
+        {R"({"baz": "qux", "foo": "bar"})", R"([{"op": "remove", "path": "/baz"}])", R"({"foo": "bar"})"},
+        {R"({"foo": ["bar", "qux", "baz"]})", R"([{"op": "remove", "path": "/foo/1"}])", R"({"foo": ["bar", "baz"]})"},
+        {R"({"baz": "qux", "foo": "bar"})", R"([{"op": "replace", "path": "/baz", "value": "boo"}])",
+            R"({"baz": "boo", "foo": "bar"})"},
+        {R"({"foo": {"bar": "baz", "waldo": "fred"}, "qux": {"corge": "grault"}})",
+            R"([{"op": "move", "from": "/foo/waldo", "path": "/qux/thud"}])",
+            R"({"foo": {"bar": "baz"}, "qux": {"corge": "grault", "thud": "fred"}})"},
+        {R"({"foo": ["all", "grass", "cows", "eat"]})", R"([{"op": "move", "from": "/foo/1", "path": "/foo/3"}])",
+            R"({"foo": ["all", "cows", "eat", "grass"]})"},
+        {R"({"foo": "bar"})", R"([{"op": "add", "path": "/child", "value": {"grandchild": {}}}])",
+            R"({"foo": "bar", "child": {"grandchild": {}}})"},
+        {R"({"foo": ["bar"]})", R"([{"op": "add", "path": "/foo/-", "value": ["abc", "def"]}])",
+            R"({"foo": ["bar", ["abc", "def"]]})"},
+        {R"({"foo": 1})", R"([{"op": "copy", "from": "/foo", "path": "/bar"}, {"op": "test", "path": "/bar", "value": 1}])",
+            R"({"foo": 1, "bar": 1})"},
+        {R"({"foo": 1})", R"([{"op": "add", "path": "", "value": [1]}])", "[1]"},
+    };
+
+    for (const auto& example : rfc6902) {
+        auto target = yajson::Value::parse(example.document);
+
+        target.applyPatch(yajson::Value::parse(example.patch));
+        success = success && target == yajson::Value::parse(example.expected);
+    }
+
+    success = success && document.resolve("/a~1b/c~0d/2") == &document["a/b"]["c~d"][2];
+    success = success && document.resolve("")->is(yajson::Value::Object);
+    success = success && nullptr == document.resolve("/a~1b/c~0d/03") && nullptr == document.resolve("/name/x");
+
+#ifndef YAJSON_NO_EXCEPTIONS
+    const char* failing[] = {
+        R"({"op": "test", "path": "/name", "value": "other"})",
+        R"({"op": "remove", "path": "/missing"})",
+        R"({"op": "add", "path": "/list/5", "value": 1})",
+        R"({"op": "add", "path": "/missing/child", "value": 1})",
+        R"({"op": "move", "from": "/b", "path": "/b/c~0d"})",
+        R"({"op": "replace", "path": "/nothing", "value": 1})",
+        R"({"op": "jump", "path": "/name"})",
+        R"({"op": "add", "path": "name", "value": 1})",
+        R"({"op": "add", "path": "/name"})",
+        R"({"op": "remove", "path": ""})",
+        R"({"path": "/name"})",
+        R"(3)",
+        R"({"op": "copy", "path": "/x"})",
+        R"({"op": "move", "from": 5, "path": "/x"})",
+        R"({"op": "move", "from": "/zzz", "path": "/zzz"})",
+        R"({"op": "move", "from": "/zzz", "path": "/x"})",
+        R"({"op": "move", "from": "/new", "path": "/list/7"})",
+        R"({"op": "move", "from": "/b", "path": "/missing/x"})",
+        R"({"op": "copy", "from": "/zzz", "path": "/x"})",
+        R"({"op": "test", "path": "/zzz", "value": 1})",
+        R"({"op": "remove", "path": "/list/9"})",
+        R"({"op": "remove", "path": "/name/x"})",
+    };
+
+    // every step before a failing one is rolled back
+    for (const auto operation : failing) {
+        try {
+            document.applyPatch(yajson::Value::parse(std::string(R"([{"op": "add", "path": "/new", "value": 1},
+                                                                     {"op": "remove", "path": "/list/0"},
+                                                                     {"op": "move", "from": "/a~1b", "path": "/b"},
+                                                                     {"op": "add", "path": "/list/-", "value": 2},
+                                                                     {"op": "add", "path": "/name", "value": 3},
+                                                                     )") + operation + "]"));
+            success = false;
+        } catch(const std::invalid_argument&) {}
+
+        success = success && document == original;
+    }
+
+    try {
+        document.applyPatch(yajson::Value::parse(R"({"op": "add", "path": "/name", "value": 1})"));
+        success = false;
+    } catch(const std::invalid_argument&) {}
+
+    try {
+        document.applyPatch(yajson::Value::parse(R"([{"op": "add", "path": "/new", "value": 1},
+                                                     {"op": "remove", "path": "/list/0"},
+                                                     {"op": "move", "from": "/a~1b", "path": "/list/0"},
+                                                     {"op": "replace", "path": "/name", "value": 2},
+                                                     {"op": "add", "path": "", "value": null},
+                                                     {"op": "test", "path": "", "value": 1}])"));
+        success = false;
+    } catch(const std::invalid_argument& exception) {
+        success = success && std::string(exception.what()).find("operation 5") != std::string::npos;
+    }
+#endif
+
+    success = success && document == original;
+
+#ifndef YAJSON_NO_EXCEPTIONS
+    try {
+        document.resolve("a");
+        success = false;
+    } catch(const std::invalid_argument&) {}
+#endif
+
+    // moves take the subtree without copying it
+    const auto text = &document["name"].stringRef();
+
+    document.applyPatch(yajson::Value::parse(R"([{"op": "move", "from": "/name", "path": "/list/-"}])"));
+    success = success && &document["list"][1].stringRef() == text && !document.has("name");
+
+    const struct {
+        const char* target;
+        const char* patch;
+        const char* expected;
+    } rfc7386[] = {
+        {R"({"a": "b"})", R"({"a": "c"})", R"({"a": "c"})"},
+        {R"({"a": "b"})", R"({"b": "c"})", R"({"a": "b", "b": "c"})"},
+        {R"({"a": "b"})", R"({"a": null})", "{}"},
+        {R"({"a": "b", "b": "c"})", R"({"a": null})", R"({"b": "c"})"},
+        {R"({"a": ["b"]})", R"({"a": "c"})", R"({"a": "c"})"},
+        {R"({"a": "c"})", R"({"a": ["b"]})", R"({"a": ["b"]})"},
+        {R"({"a": {"b": "c"}})", R"({"a": {"b": "d", "c": null}})", R"({"a": {"b": "d"}})"},
+        {R"({"a": [{"b": "c"}]})", R"({"a": [1]})", R"({"a": [1]})"},
+        {R"(["a", "b"])", R"(["c", "d"])", R"(["c", "d"])"},
+        {R"({"a": "b"})", R"(["c"])", R"(["c"])"},
+        {R"({"a": "foo"})", "null", "null"},
+        {R"({"a": "foo"})", R"("bar")", R"("bar")"},
+        {R"({"e": null})", R"({"a": 1})", R"({"e": null, "a": 1})"},
+        {R"([1, 2])", R"({"a": "b", "c": null})", R"({"a": "b"})"},
+        {"{}", R"({"a": {"bb": {"ccc": null}}})", R"({"a": {"bb": {}}})"},
+    };
+
+    for (const auto& example : rfc7386) {
+        auto target = yajson::Value::parse(example.target);
+
+        target.mergePatch(yajson::Value::parse(example.patch));
+        success = success && target == yajson::Value::parse(example.expected);
+    }
+
+    if (!success) {
+        printf("FAIL %s\n", __func__);
+    }
+
+    return success;
+}
+
+static bool testDiff() {
+    bool success = true;
+    const struct {
+        const char* from;
+        const char* to;
+        const char* patch;
+    } examples[] = {
+        {R"({"a": [1, {"b": null}]})", R"({"a": [1, {"b": null}]})", "[]"},
+        {R"({"a": 1, "b": 2})", R"({"a": 1, "b": 3, "c": 4})",
+            R"([{"op": "replace", "path": "/b", "value": 3}, {"op": "add", "path": "/c", "value": 4}])"},
+        {R"({"a/b": 1, "c~d": 2})", R"({"c~d": 2})", R"([{"op": "remove", "path": "/a~1b"}])"},
+        {"[1, 2, 3, 4, 5]", "[1, 2, 9, 3, 4, 5]", R"([{"op": "add", "path": "/2", "value": 9}])"},
+        {"[1, 2, 3, 4, 5]", "[1, 3, 4, 5]", R"([{"op": "remove", "path": "/1"}])"},
+        {R"([{"id": 1, "v": 1}, {"id": 2}])", R"([{"id": 1, "v": 2}, {"id": 2}])",
+            R"([{"op": "replace", "path": "/0/v", "value": 2}])"},
+        {"[1, 2, 3]", "[3, 2, 1]", R"([{"op": "replace", "path": "/0", "value": 3},
+                                       {"op": "replace", "path": "/2", "value": 1}])"},
+        {R"({"a": [1]})", R"({"a": {"0": 1}})", R"([{"op": "replace", "path": "/a", "value": {"0": 1}}])"},
+        {"1", "1.0", R"([{"op": "replace", "path": "", "value": 1.0}])"},
+        {R"([[[1]], {"a": [[2]], "b": [3]}])", R"([[[1]], {"a": [[4]], "b": [3]}])",
+            R"([{"op": "replace", "path": "/1/a/0/0", "value": 4}])"},
+    };
+    unsigned seed = 1;
+    const auto random = [&seed](unsigned limit) {
+        seed = seed * 1103515245u + 12345u;
+        return (seed >> 16) % limit;
+    };
+
+    for (const auto& example : examples) {
+        const auto from = yajson::Value::parse(example.from);
+        const auto to = yajson::Value::parse(example.to);
+        const auto patch = yajson::Value::diff(from, to);
+        auto patched = from;
+
+        patched.applyPatch(patch);
+        success = success && patch == yajson::Value::parse(example.patch) && patched == to;
+    }
+
+    for (int round = 0; round < 200; ++round) {
+        auto from = yajson::Value::array();
+
+        for (unsigned i = random(12); i > 0; --i) {
+            from.append(static_cast<int>(random(5)));
+        }
+
+        auto to = from;
+
+        for (unsigned edits = random(5); edits > 0; --edits) {
+            const auto index = random(static_cast<unsigned>(to.count()) + 1);
+
+            if ((random(3) == 0) && (index < static_cast<unsigned>(to.count()))) {
+                to.erase(index, index + 1);
+            } else if (random(2) == 0) {
+                to.insert(yajson::Value(static_cast<int>(random(5))), index);
+            } else if (index < static_cast<unsigned>(to.count())) {
+                to[index] = static_cast<int>(random(5));
+            }
+        }
+
+        auto patched = from;
+
+        patched.applyPatch(yajson::Value::diff(from, to));
+        success = success && patched == to;
+    }
+
+    const auto many = yajson::Value::parse("[1, 2, 3, 4, 5, 6, 7, 8]");
+    const auto reversed = yajson::Value::parse("[8, 7, 6, 5, 4, 3, 2, 1]");
+
+    success = success && yajson::Patch::diff(many, reversed, 10)
+                            == yajson::Value::parse(R"([{"op": "replace", "path": "", "value": [8, 7, 6, 5, 4, 3, 2, 1]}])");
+    success = success && yajson::Patch::diff(many, reversed).count() == 8;
+
+    if (!success) {
+        printf("FAIL %s\n", __func__);
+    }
+
+    return success;
+}
+
+static bool testCursor() {
+    bool success = true;
+    std::string records = "[";
+
+    for (int i = 0; i < 1000; ++i) {
+        records += (i > 0 ? ",\n  " : "") + std::string(R"({"id": )") + std::to_string(i)
+                    + R"(, "name": "record \")" + std::to_string(i) + R"(\"", "tags": [1, [2, {"x": "]}"}]]})";
+    }
+
+    records += "]";
+
+    for (const size_t bufferSize : {size_t(1), size_t(7), size_t(64), yajson::Cursor::BufferSize}) {
+        std::istringstream stream(records);
+        yajson::Cursor cursor(stream, bufferSize);
+        yajson::Value record;
+        int count = 0;
+
+        success = success && cursor.enter();
+
+        while (cursor.next()) {
+            success = success && cursor.read(record) && record["id"].integer() == count
+                        && record["name"].string() == "record \"" + std::to_string(count) + "\"";
+            ++count;
+        }
+
+        success = success && count == 1000 && cursor.done() && !cursor.failed() && cursor.offset() == records.size();
+    }
+
+    std::istringstream nested(R"( {"skip": {"a": [1, 2]}, "items": [10, "x", [3], 11], "tail": 1e3 } )");
+    yajson::Cursor cursor(nested, 3);
+    yajson::Value item;
+    std::string keys;
+
+    success = success && cursor.enter();
+
+    while (cursor.next()) {
+        keys += cursor.key() + ",";
+
+        if (cursor.key() == "items") {
+            int count = 0;
+
+            success = success && cursor.enter();
+
+            while (cursor.next()) {
+                if (count++ == 0) {
+                    success = success && cursor.read(item) && item == yajson::Value(10);
+                }
+            }
+
+            success = success && count == 4;
+        } else if (cursor.key() == "tail") {
+            success = success && cursor.read(item) && item.format() == "1e3";
+        }
+    }
+
+    success = success && keys == "skip,items,tail," && cursor.done();
+
+    const struct {
+        const char* text;
+        yajson::Value::ParseError::Code code;
+        size_t offset;
+    } failures[] = {
+        {"[1, 2", yajson::Value::ParseError::UnexpectedEnd, 5},
+        {"[1 2]", yajson::Value::ParseError::UnexpectedCharacter, 3},
+        {"[1, ]", yajson::Value::ParseError::UnexpectedCharacter, 4},
+        {"[1, tru]", yajson::Value::ParseError::InvalidLiteral, 4},
+        {"[[1}]", yajson::Value::ParseError::UnexpectedCharacter, 3},
+        {"{1: 2}", yajson::Value::ParseError::UnexpectedCharacter, 1},
+        {"12", yajson::Value::ParseError::TypeMismatch, 0},
+        {"{\"a\" 1}", yajson::Value::ParseError::UnexpectedCharacter, 5},
+        {"{\"a\": 1 \"b\": 2}", yajson::Value::ParseError::UnexpectedCharacter, 8},
+        {"{\"a", yajson::Value::ParseError::UnexpectedEnd, 3},
+        {"{\"a\"", yajson::Value::ParseError::UnexpectedEnd, 4},
+        {"{\"a\xFF\": 1}", yajson::Value::ParseError::InvalidCodepoint, 3},
+        {"[{\"id\": 1}, {\"id\": 2, \"name\": \"trunc", yajson::Value::ParseError::UnexpectedEnd, 36},
+        {"[1, 2] x", yajson::Value::ParseError::UnexpectedCharacter, 7},
+        {"[] []", yajson::Value::ParseError::UnexpectedCharacter, 3},
+    };
+
+    for (const auto& failure : failures) {
+        for (const size_t bufferSize : {size_t(1), size_t(2), size_t(7), size_t(64)}) {
+            std::istringstream stream(failure.text);
+            yajson::Cursor broken(stream, bufferSize);
+            int count = 0;
+
+            if (broken.enter()) {
+                while (broken.next() && count < 10) {
+                    broken.read(item);
+                    ++count;
+                }
+            }
+
+            success = success && broken.failed() && !broken.done() && broken.error().code == failure.code
+                        && broken.error().offset == failure.offset;
+        }
+    }
+
+    // a failed read leaves the value pending, and every later call fails the same way
+    std::istringstream literal("[1, tru]");
+    yajson::Cursor stuck(literal, 2);
+
+    success = success && stuck.enter() && stuck.next() && stuck.read(item) && stuck.next() && !stuck.read(item);
+    success = success && !stuck.skip() && !stuck.enter() && !stuck.read(item);
+    success = success && stuck.error().code == yajson::Value::ParseError::InvalidLiteral && stuck.error().offset == 4;
+
+    std::istringstream deep(std::string(yajson::Parser::MaximumDepth + 1, '['));
+    yajson::Cursor nesting(deep, 16);
+    size_t depth = 0;
+
+    while (nesting.enter() && nesting.next()) {
+        ++depth;
+    }
+
+    success = success && depth == yajson::Parser::MaximumDepth;
+    success = success && nesting.error().code == yajson::Value::ParseError::NestingTooDeep;
+    success = success && nesting.error().offset == yajson::Parser::MaximumDepth;
+
+    std::istringstream junk("5 \n x");
+    yajson::Cursor trailing(junk, 2);
+
+    success = success && !trailing.read(item) && trailing.failed() && !trailing.done();
+    success = success && trailing.error().code == yajson::Value::ParseError::UnexpectedCharacter;
+    success = success && trailing.error().offset == 4;
+
+    std::istringstream skipped("{} 1");
+    yajson::Cursor skipping(skipped, 2);
+
+    success = success && !skipping.skip() && skipping.error().offset == 3;
+
+#ifndef YAJSON_NO_EXCEPTIONS
+    std::istringstream scalar("5");
+    yajson::Cursor top(scalar);
+
+    success = success && top.read(item) && item == yajson::Value(5) && top.done();
+
+    try {
+        top.next();
+        success = false;
+    } catch(const std::invalid_argument&) {}
+#endif
+
+    if (!success) {
+        printf("FAIL %s\n", __func__);
+    }
+
+    return success;
+}
+
+static bool testProjection() {
+    bool success = true;
+    const std::string event = R"({
+        "id": 7, "type": "click",
+        "payload": {"user": {"id": 3, "name": "Aé", "roles": ["x"]}, "blob": "skipped \"]}\" text", "n": 1e999},
+        "items": [{"sku": "a", "price": 2, "extra": [1, {"deep": null}]}, 5, {"price": 3}],
+        "ignored": [[[{"a": [tru, 0x1]}]]]
+    })";
+    const yajson::Projection projection = {"/id", "/payload/user/name", "/payload/user/roles", "/items/price",
+                                           "/missing/path", "/type/nested"};
+    const auto projected = yajson::Value::parse(event, projection);
+
+    success = success && projected == yajson::Value::parse(R"({
+        "id": 7,
+        "payload": {"user": {"name": "Aé", "roles": ["x"]}},
+        "items": [{"price": 2}, {"price": 3}]
+    })");
+
+    const yajson::Projection everything = {""};
+    const yajson::Projection nothing;
+    yajson::Value value;
+    yajson::Value::ParseError error;
+
+    success = success && yajson::Value::parse(R"({"a": [1, 2]})", everything) == yajson::Value::parse(R"({"a": [1, 2]})");
+    success = success && nothing.empty() && !everything.empty();
+    success = success && yajson::Value::parse(R"({"a": [1, 2]})", nothing) == yajson::Value::object();
+    success = success && yajson::Value::parse("42", nothing).isNull();
+    success = success && yajson::Value::parse(R"({"a": {"c": 1}, "b": 2})", yajson::Projection({"/a/b"}))
+                            == yajson::Value::object();
+    success = success && yajson::Value::parse(R"({"items": [{"sku": "x"}, [], {"price": 1}]})", projection)
+                            == yajson::Value::parse(R"({"items": [{"price": 1}]})");
+    success = success && yajson::Value::parse(R"([{"x": 1}])", nothing) == yajson::Value::array();
+
+    // skipped members count the depth they are found at
+    const auto limit = yajson::Parser::MaximumDepth;
+    const std::string tower = std::string(limit - 10, '[') + R"({"x": )" + std::string(20, '[') + std::string(20, ']')
+                                + "}" + std::string(limit - 10, ']');
+
+    success = success && !yajson::Value::tryParse(tower.data(), tower.size(), projection, value, error)
+                && error.code == yajson::Value::ParseError::NestingTooDeep;
+    success = success && !yajson::Value::tryParse(tower, value, error)
+                && error.code == yajson::Value::ParseError::NestingTooDeep;
+
+    std::istringstream deep("[" + std::string(limit, '[') + std::string(limit, ']') + "]");
+    yajson::Cursor skipping(deep);
+
+    success = success && skipping.enter() && skipping.next() && !skipping.skip()
+                && skipping.error().code == yajson::Value::ParseError::NestingTooDeep;
+    success = success && yajson::Value::parse(R"({"a~b": {"c/d": 1, "e": 2}})", yajson::Projection({"/a~0b/c~1d", "/a~0b"}))
+                            == yajson::Value::parse(R"({"a~b": {"c/d": 1, "e": 2}})");
+
+    success = success && !yajson::Value::tryParse(R"({"id": tru})", 11, projection, value, error)
+                && error.code == yajson::Value::ParseError::InvalidLiteral;
+    success = success && !yajson::Value::tryParse(R"({"x": [1}, "id": 1})", 20, projection, value, error)
+                && error.code == yajson::Value::ParseError::UnexpectedCharacter && error.offset == 8;
+
+    std::istringstream stream(R"([{"id": 1, "body": "..."}, {"id": 2, "body": [1, 2, 3]}])");
+    yajson::Cursor cursor(stream);
+    int total = 0;
+
+    success = success && cursor.enter();
+
+    while (cursor.next()) {
+        success = success && cursor.read(value, yajson::Projection({"/id"})) && value.count() == 1;
+        total += static_cast<int>(value["id"].integer());
+    }
+
+    success = success && total == 3 && cursor.done();
+
+#ifndef YAJSON_NO_EXCEPTIONS
+    try {
+        yajson::Projection({"id"});
+        success = false;
+    } catch(const std::invalid_argument&) {}
+#endif
+
+    if (!success) {
+        printf("FAIL %s\n", __func__);
+    }
+
+    return success;
+}
+
+static bool testParallelFormat() {
+    bool success = true;
+    auto rows = yajson::Value::array();
+    auto table = yajson::Value::object();
+
+    for (int i = 0; i < 1000; ++i) {
+        auto row = yajson::Value::object();
+
+        row["id"] = i;
+        row["name"] = "row é " + std::to_string(i);
+        row["values"] = yajson::Value::array();
+        row["values"].append(i).append(yajson::Value::array()).append(yajson::Value::object());
+        rows.append(row);
+        table["k" + std::to_string(i)] = row;
+    }
+
+    table["\U0001F600"] = 1;
+    table["�"] = 2;
+
+    for (const int indent : {-1, 0, 2}) {
+        for (const unsigned threads : {0u, 2u, 3u, 8u, 5000u}) {
+            yajson::Value::FormatOptions serial(indent);
+            yajson::Value::FormatOptions parallel(indent);
+
+            serial.keyOrder = yajson::Value::FormatOptions::Utf16Order;
+            parallel.keyOrder = yajson::Value::FormatOptions::Utf16Order;
+            parallel.threads = threads;
+            parallel.minimumChunk = 1;
+
+            std::string buffer;
+            yajson::Output counter;
+
+            success = success && rows.format(parallel) == rows.format(serial);
+            success = success && table.format(buffer, parallel) == table.format(serial);
+            success = success && yajson::Value::parse(buffer) == table;
+
+            table.format(counter, parallel);
+            success = success && counter.size() == table.formattedSize(indent);
+        }
+    }
+
+    yajson::Value::FormatOptions options;
+
+    options.threads = 4;
+    success = success && yajson::Value::parse("[]").format(options) == "[]"
+                && yajson::Value::parse("[1]").format(options) == "[1]"
+                && yajson::Value::parse(R"({"a": [1, 2]})").format(options) == R"({"a":[1,2]})"
+                && yajson::Value(5).format(options) == "5";
+
+    // small containers stay on the calling thread; each thread gets at least minimumChunk items
+    std::unordered_set<std::thread::id> workers;
+    std::mutex workersLock;
+    const auto record = [&workers, &workersLock](yajson::Output& out, size_t, const yajson::Value::FormatOptions&) {
+        std::lock_guard<std::mutex> guard(workersLock);
+
+        workers.insert(std::this_thread::get_id());
+        out.append('0');
+    };
+
+    options.threads = 8;
+
+    for (const size_t count : {size_t(2), options.minimumChunk, 2 * options.minimumChunk - 1}) {
+        yajson::Output counter;
+
+        workers.clear();
+        yajson::Instance::formatItems(counter, options, 0, count, '[', ']', record);
+        success = success && workers.size() == 1 && workers.count(std::this_thread::get_id()) == 1;
+        success = success && counter.size() == 2 * count + 1;
+    }
+
+    workers.clear();
+
+    yajson::Output counter;
+
+    yajson::Instance::formatItems(counter, options, 0, 3 * options.minimumChunk, '[', ']', record);
+    success = success && workers.size() > 1; // finished threads may hand their id on
+
+#ifndef YAJSON_NO_EXCEPTIONS
+    options.minimumChunk = 1;
+
+    auto broken = yajson::Value::array();
+
+    for (int i = 0; i < 10; ++i) {
+        broken.append(i == 7 ? yajson::Value(std::string("\xff")) : yajson::Value(i));
+    }
+
+    options.unicode = yajson::Value::FormatOptions::AsciiOnly;
+
+    try {
+        broken.format(options);
+        success = false;
+    } catch(const std::invalid_argument&) {}
+#endif
+
+    if (!success) {
+        printf("FAIL %s\n", __func__);
+    }
+
+    return success;
+}
+
+static bool testParallelParse() {
+    bool success = true;
+    std::string records = " [";
+
+    for (int i = 0; i < 400; ++i) {
+        records += (i > 0 ? ", " : "") + std::string(R"({"id": )") + std::to_string(i)
+                    + R"(, "text": "q\"[,{\\", "nested": [[1, {"a": ","}], "\\\\\""], "e": {}})";
+    }
+
+    records += "] ";
+
+    const auto expected = yajson::Value::parse(records);
+    std::string members = "{";
+
+    for (int i = 0; i < 300; ++i) {
+        members += (i > 0 ? ",\n" : "") + std::string("\"k") + std::to_string(i % 250) + "\": [\"" + std::to_string(i) + ",\"]";
+    }
+
+    members += "}";
+
+    const auto expectedMembers = yajson::Value::parse(members);
+
+    for (const unsigned threads : {1u, 2u, 3u, 7u, 64u}) {
+        for (const size_t minimumChunk : {size_t(1), size_t(5), size_t(97), size_t(4096)}) {
+            yajson::Value value;
+            yajson::Parser parser(records.data(), records.size());
+
+            success = success && parser.parseParallel(value, threads, minimumChunk) && value == expected
+                        && parser.offset() == records.size() - 1;
+
+            yajson::Parser objectParser(members.data(), members.size());
+
+            success = success && objectParser.parseParallel(value, threads, minimumChunk)
+                        && value == expectedMembers && value["k3"][0].string() == "253,";
+        }
+    }
+
+    success = success && yajson::Value::parseParallel(records, 4) == expected;
+    success = success && yajson::Value::parseParallel("[]", 4) == yajson::Value::array();
+    success = success && yajson::Value::parseParallel("12", 4) == yajson::Value(12);
+
+    const char* const broken[] = {
+        "[1, 2, 3, 4, 5, 6, 7, 8, 9, 10 11, 12, 13, 14]",
+        "[1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14",
+        "[1, 2, 3, \"4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14]",
+        "[1, 2, 3, 4, 5, 6, 7, [8, 9, 10, 11, 12, 13, 14]",
+        "[1, 2, 3, 4, 5, 6, 7, 8], 9, 10, 11, 12, 13, 14]",
+        "[1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, ]",
+        "{\"a\": 1, \"b\": 2, \"c\": 3, \"d\" 4, \"e\": 5, \"f\": 6}",
+        "[1, 2, 3, 4, \\\"5, 6, 7, 8, 9, 10\\\", 11, 12, 13, 14]",
+    };
+
+    for (const auto text : broken) {
+        const size_t length = strlen(text);
+
+        for (const size_t minimumChunk : {size_t(1), size_t(3), size_t(10)}) {
+            yajson::Value serialValue;
+            yajson::Value parallelValue;
+            yajson::Parser serial(text, length);
+            yajson::Parser parallel(text, length);
+            const bool serialSuccess = serial.parse(serialValue);
+            const bool parallelSuccess = parallel.parseParallel(parallelValue, 5, minimumChunk);
+
+            success = success && serialSuccess == parallelSuccess && serialValue == parallelValue
+                        && serial.offset() == parallel.offset() && serial.error().code == parallel.error().code
+                        && serial.error().offset == parallel.error().offset;
+        }
+    }
+
+    if (!success) {
+        printf("FAIL %s\n", __func__);
+    }
+
+    return success;
+}
+
+static bool testCapacity() {
+    bool success = true;
+    std::string text = "[";
+
+    for (int i = 0; i < 1000; ++i) {
+        text += (i > 0 ? ", " : "") + std::string(i % 10 == 0 ? "[1, [2, 3], []]" : std::to_string(i));
+    }
+
+    text += "]";
+
+    const auto parsed = yajson::Value::parse(text);
+
+    success = success && parsed.count() == 1000 && parsed.elements()->capacity() == 1000
+                && parsed[10].elements()->capacity() == 3 && parsed[10][1].elements()->capacity() == 2
+                && parsed.format() == yajson::Value::parse(parsed.format()).format();
+
+    auto array = yajson::Value::array();
+    auto object = yajson::Value::object();
+
+    array.reserve(100);
+    object.reserve(100);
+    success = success && array.elements()->capacity() >= 100 && array.count() == 0;
+
+    auto left = yajson::Value::parse(R"([1, 2, 3])");
+    auto right = yajson::Value::parse(R"([{"big": [4]}, 5, 6])");
+    const auto* moved = right[0].members();
+
+    left.extend(std::move(right));
+    success = success && left == yajson::Value::parse(R"([1, 2, 3, {"big": [4]}, 5, 6])")
+                && right.count() == 0 && left[3].members() == moved;
+
+    left.extend(left);
+    success = success && left.count() == 12 && left[9] == left[3];
+
+    auto source = yajson::Value::parse("[10, 11, 12, 13]");
+    auto target = yajson::Value::parse("[0, 1]");
+
+    target.splice(1, source, 1, 3);
+    success = success && target == yajson::Value::parse("[0, 11, 12, 1]") && source == yajson::Value::parse("[10, 13]");
+    target.splice(0, target, 2);
+    success = success && target == yajson::Value::parse("[12, 1, 0, 11]");
+    target.splice(4, target, 0, 2);
+    success = success && target == yajson::Value::parse("[0, 11, 12, 1]");
+    target.splice(2, target, 1, 3);
+    success = success && target == yajson::Value::parse("[0, 11, 12, 1]");
+    target.splice(100, source, 5, 1).extend(yajson::Value());
+    success = success && target.count() == 4 && source.count() == 2;
+
+#ifndef YAJSON_NO_EXCEPTIONS
+    try {
+        object.extend(yajson::Value::parse("[1]"));
+        success = false;
+    } catch(const std::domain_error&) {}
+
+    try {
+        target.extend(yajson::Value::parse(R"({"a": 1})"));
+        success = false;
+    } catch(const std::domain_error&) {}
+
+    try {
+        yajson::Value().reserve(1);
+        success = false;
+    } catch(const std::domain_error&) {}
+
+    try {
+        yajson::Value(1).reserve(1);
+        success = false;
+    } catch(const std::domain_error&) {}
+#endif
+
+    if (!success) {
+        printf("FAIL %s\n", __func__);
+    }
+
+    return success;
+}
+
+static bool testFreeze() {
+    bool success = true;
+    const auto document = yajson::Value::parse(R"({
+        "name": "frozen", "version": 3, "ratio": 0.5, "big": 123456789012345678901234567890,
+        "tags": ["a", "b", "a"], "empty": {}, "none": null,
+        "rows": [{"id": 1, "ok": true}, {"id": 2, "ok": false}]
+    })");
+    const auto frozen = document.freeze();
+    const yajson::SnapshotView& view = frozen.view();
+
+    success = success && frozen.is(yajson::Value::Object) && frozen.count() == 8
+                && frozen["name"].string() == "frozen" && frozen["version"].integer() == 3
+                && frozen["rows"][1]["id"].integer() == 2 && !frozen["rows"][1]["ok"].boolean()
+                && frozen["missing"].isNull() && frozen["none"].isNull() && !frozen.has("missing")
+                && frozen.keys() == document.keys() && frozen.key(0).string() == "big"
+                && view["tags"].count() == 3 && frozen.value() == document;
+
+    yajson::FrozenValue copy;
+
+    success = success && copy.isNull() && copy.value().isNull();
+    copy = frozen;
+
+    yajson::FrozenValue moved(std::move(copy));
+
+    success = success && moved.data() == frozen.data() && moved["rows"][0]["id"].integer() == 1;
+    success = success && moved.size() < document.format().size() + 256;
+
+    // lookups share the block, so a child outlives the value it came from
+    yajson::FrozenValue child;
+
+    {
+        const auto parent = document.freeze();
+
+        child = parent["rows"][1];
+    }
+
+    success = success && child["id"].integer() == 2 && !child.at("ok").boolean() && child.member(0).integer() == 2
+                && child.value() == document["rows"][1] && child.data() != frozen.data();
+
+    auto rows = yajson::Value::array();
+
+    for (int i = 0; i < 100; ++i) {
+        auto row = yajson::Value::object();
+
+        row["id"] = i;
+        row["name"] = "row " + std::to_string(i % 10);
+        rows.append(std::move(row));
+    }
+
+    const auto frozenRows = rows.freeze();
+    int64_t total = 0;
+
+    for (int i = 0; i < frozenRows.count(); ++i) {
+        total += frozenRows[static_cast<size_t>(i)]["id"].integer();
+    }
+
+    success = success && total == 4950 && frozenRows.value() == rows;
+
+    if (!success) {
+        printf("FAIL %s\n", __func__);
+    }
+
+    return success;
+}
+
+static bool testCanonical() {
+    bool success = true;
+    const struct {
+        uint64_t bits;
+        const char* text;
+    } numbers[] = { // RFC 8785 appendix B
+        {0x0000000000000000, "0"}, {0x8000000000000000, "0"}, {0x0000000000000001, "5e-324"},
+        {0x8000000000000001, "-5e-324"}, {0x7fefffffffffffff, "1.7976931348623157e+308"},
+        {0xffefffffffffffff, "-1.7976931348623157e+308"}, {0x4340000000000000, "9007199254740992"},
+        {0xc340000000000000, "-9007199254740992"}, {0x4430000000000000, "295147905179352830000"},
+        {0x44b52d02c7e14af5, "9.999999999999997e+22"}, {0x44b52d02c7e14af6, "1e+23"},
+        {0x44b52d02c7e14af7, "1.0000000000000001e+23"}, {0x444b1ae4d6e2ef4e, "999999999999999700000"},
+        {0x444b1ae4d6e2ef4f, "999999999999999900000"}, {0x444b1ae4d6e2ef50, "1e+21"},
+        {0x3eb0c6f7a0b5ed8c, "9.999999999999997e-7"}, {0x3eb0c6f7a0b5ed8d, "0.000001"},
+        {0x41b3de4355555553, "333333333.3333332"}, {0x41b3de4355555554, "333333333.33333325"},
+        {0x41b3de4355555555, "333333333.3333333"}, {0x41b3de4355555556, "333333333.3333334"},
+        {0x41b3de4355555557, "333333333.33333343"}, {0xbecbf647612f3696, "-0.0000033333333333333333"},
+        {0x43143ff3c1cb0959, "1424953923781206.2"},
+    };
+
+    for (const auto& number : numbers) {
+        double value = 0.0;
+
+        memcpy(&value, &number.bits, sizeof(value));
+        success = success && yajson::Value(value).canonical() == number.text;
+    }
+
+    const auto document = yajson::Value::parse(R"({
+        "numbers": [333333333.33333329, 1E30, 4.50, 2e-3, 0.000000000000000000000000001],
+        "string": "\u20ac$\u000F\u000aA'\u0042\u0022\u005c\\\"\/",
+        "literals": [null, true, false]
+    })");
+    const std::string expected = R"({"literals":[null,true,false],"numbers":[333333333.3333333,1e+30,4.5,0.002,1e-27],)"
+                                 R"("string":"€$\u000f\nA'B\"\\\\\"/"})";
+
+    success = success && document.canonical() == expected;
+
+    const auto keys = yajson::Value::parse(R"({"\u20ac": 1, "\r": 2, "\ufb33": 3, "1": 4, "\ud83d\ude00": 5,
+                                               "\u0080": 6, "\u00f6": 7})");
+
+    success = success && keys.canonical() == "{\"\\r\":2,\"1\":4,\"\xc2\x80\":6,\"\xc3\xb6\":7,\"\xe2\x82\xac\":1,"
+                                              "\"\xf0\x9f\x98\x80\":5,\"\xef\xac\xb3\":3}";
+
+    auto built = yajson::Value::object();
+
+    built["big"] = int64_t(9007199254740993);
+    built["small"] = -12;
+    built["real"] = 100.0;
+    built["huge"] = yajson::Value::parse("18446744073709551616");
+    success = success && built.canonical() == R"({"big":9007199254740992,"huge":18446744073709552000,"real":100,"small":-12})";
+
+    std::string streamed;
+    size_t writes = 0;
+    yajson::CallbackSink sink([&streamed, &writes](const char* text, size_t size) {
+        streamed.append(text, size);
+        writes += 1;
+    });
+
+    document.canonical(sink);
+    success = success && streamed == expected && writes >= 1;
+
+    std::string written;
+    yajson::StringSink stringSink(written);
+    yajson::Writer writer(stringSink, yajson::Value::FormatOptions::canonical());
+
+    writer.beginArray().value(0.1).value(int64_t(-9007199254740993)).value(uint64_t(1) << 60).endArray().flush();
+    success = success && written == "[0.1,-9007199254740992,1152921504606847000]";
+    success = success && yajson::Value(0.1).format() == "0.100000";
+
+#ifndef YAJSON_NO_EXCEPTIONS
+    try {
+        yajson::Value(std::nan("")).canonical();
+        success = false;
+    } catch(const std::domain_error&) {}
+
+    try {
+        yajson::Value::parse("[1e999]").canonical();
+        success = false;
+    } catch(const std::domain_error&) {}
+#endif
+
+    if (!success) {
+        printf("FAIL %s\n", __func__);
+    }
+
+    return success;
+}
+
+static bool testMerge() {
+    bool success = true;
+    auto config = yajson::Value::parse(R"({"server": {"host": "localhost", "port": 80, "tls": {"enabled": false}},
+                                          "timeout": 30, "tags": ["a"], "name": "defaults"})");
+    auto overlay = yajson::Value::parse(R"({"server": {"port": 8080, "tls": {"enabled": true, "ca": "/etc/ca"}},
+                                           "timeout": 2.5, "tags": ["b"], "limits": {"rows": [1, 2]},
+                                           "name": null})");
+    const auto rows = overlay["limits"]["rows"].elements();
+
+    config.merge(std::move(overlay));
+    success = success && config == yajson::Value::parse(R"({"server": {"host": "localhost", "port": 8080,
+                                                                      "tls": {"enabled": true, "ca": "/etc/ca"}},
+                                                           "timeout": 2.5, "tags": ["b"], "limits": {"rows": [1, 2]},
+                                                           "name": null})");
+    success = success && overlay.isNull() && config["limits"]["rows"].elements() == rows; // moved, not copied
+
+    const auto tags = yajson::Value::parse(R"({"tags": ["c", "d"]})");
+    yajson::Value::MergePolicy append(yajson::Value::MergePolicy::Append);
+
+    config.merge(tags, append);
+    success = success && config["tags"].format() == R"(["b","c","d"])" && tags["tags"].count() == 2;
+
+    auto users = yajson::Value::parse(R"([{"id": 1, "name": "ann", "roles": ["dev"]}, {"id": 2, "name": "bob"},
+                                          "loose", {"name": "nobody"}])");
+    yajson::Value::MergePolicy byKey(yajson::Value::MergePolicy::ByKey);
+
+    byKey.arrayKey = "id";
+    users.merge(yajson::Value::parse(R"([{"id": 2, "name": "bo"}, {"id": 3, "name": "cy"}, {"name": "anon"},
+                                         {"id": 1, "roles": ["ops"]}, 7])"), byKey);
+    success = success && users == yajson::Value::parse(R"([{"id": 1, "name": "ann", "roles": ["dev", "ops"]},
+                                                         {"id": 2, "name": "bo"}, "loose", {"name": "nobody"},
+                                                         {"id": 3, "name": "cy"}, {"name": "anon"}, 7])");
+
+    auto base = yajson::Value::parse(R"({"a": {"b": [1]}, "c": "text"})");
+    const auto conflicting = yajson::Value::parse(R"({"a": {"b": {"x": 1}}, "c": 5})");
+    auto kept = base;
+
+    kept.merge(conflicting, yajson::Value::MergePolicy(yajson::Value::MergePolicy::Replace,
+                                                       yajson::Value::MergePolicy::TargetWins));
+    success = success && kept == base;
+    kept.merge(conflicting);
+    success = success && kept == conflicting;
+
+    yajson::Value empty;
+
+    empty.merge(base);
+    success = success && empty == base;
+
+#ifndef YAJSON_NO_EXCEPTIONS
+    const yajson::Value::MergePolicy strict(yajson::Value::MergePolicy::ByKey, yajson::Value::MergePolicy::Fail);
+    auto items = yajson::Value::parse(R"({"items": [{"": "k", "v": 1}], "n": 1})");
+    const auto before = items;
+
+    try {
+        auto late = yajson::Value::parse(R"({"n": 2.5, "items": [{"": "k", "v": "one"}], "z": 1})");
+
+        items.merge(std::move(late), strict);
+        success = false;
+    } catch(const std::domain_error& exception) {
+        success = success && std::string(exception.what()) == "type conflict at /items/0/v" && items == before;
+    }
+
+    try {
+        items.merge(yajson::Value::array(), strict);
+        success = false;
+    } catch(const std::domain_error& exception) {
+        success = success && std::string(exception.what()) == "type conflict at /";
+    }
+
+    items.merge(yajson::Value::parse(R"({"items": [{"": "k", "v": 2}, {"": "j"}]})"), strict);
+    success = success && items["items"].format() == R"([{"":"k","v":2},{"":"j"}])";
+#endif
+
+    if (!success) {
+        printf("FAIL %s\n", __func__);
+    }
+
+    return success;
+}
+
 int main(const int /*argc*/, const char* const /*argv*/[]) {
     int failures = 0;
 
@@ -588,6 +2747,31 @@ int main(const int /*argc*/, const char* const /*argv*/[]) {
     failures += testUnicode() ? 0 : 1;
     failures += testMiscellaneous() ? 0 : 1;
     failures += testArrayInsertConditions() ? 0 : 1;
+    failures += testConstLookup() ? 0 : 1;
+    failures += testTryParse() ? 0 : 1;
+    failures += testValidate() ? 0 : 1;
+    failures += testFormattedSize() ? 0 : 1;
+    failures += testFormatOptions() ? 0 : 1;
+    failures += testLazyNumbers() ? 0 : 1;
+    failures += testBinding() ? 0 : 1;
+    failures += testBindingFormat() ? 0 : 1;
+    failures += testWriter() ? 0 : 1;
+    failures += testParseInto() ? 0 : 1;
+    failures += testNonThrowingAccessors() ? 0 : 1;
+    failures += testKeyLookup() ? 0 : 1;
+    failures += testHash() ? 0 : 1;
+    failures += testBinary() ? 0 : 1;
+    failures += testSnapshot() ? 0 : 1;
+    failures += testPatch() ? 0 : 1;
+    failures += testDiff() ? 0 : 1;
+    failures += testCursor() ? 0 : 1;
+    failures += testProjection() ? 0 : 1;
+    failures += testParallelFormat() ? 0 : 1;
+    failures += testParallelParse() ? 0 : 1;
+    failures += testCapacity() ? 0 : 1;
+    failures += testFreeze() ? 0 : 1;
+    failures += testCanonical() ? 0 : 1;
+    failures += testMerge() ? 0 : 1;
 
     if (failures > 0) {
         printf("FAIL %d tests\n", failures);
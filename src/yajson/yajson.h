@@ -17,19 +17,141 @@ If you feel generous, you can submit your changes back to the original work.
 #include <sstream>
 #include <iomanip>
 #include <map>
+#include <unordered_map>
 #include <iterator>
 #include <algorithm>
+#include <stdexcept>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cinttypes>
+#include <cmath>
+#include <functional>
+#include <future>
+#include <thread>
+#include <initializer_list>
+#include <ostream>
+#include <istream>
+#if __cplusplus >= 201703L
+#include <string_view>
+#include <charconv>
+#endif
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+#if !defined(YAJSON_NO_EXCEPTIONS) && !defined(__cpp_exceptions) && !defined(__EXCEPTIONS) && !defined(_CPPUNWIND)
+#define YAJSON_NO_EXCEPTIONS
+#endif
 
 namespace yajson {
 
 class Instance;
+class Parser;
+class Output;
+class Sink;
+class SnapshotView;
+class FrozenValue;
+class Projection;
+
+class Key {
+public:
+    Key(const char* text);
+    Key(const char* text, size_t size);
+    Key(const std::string& text);
+#if __cplusplus >= 201703L
+    Key(std::string_view text);
+#endif
+
+    const char* data() const;
+    size_t size() const;
+    std::string string() const;
+    int compare(const std::string& other) const;
+private:
+    const char* _data;
+    size_t _size;
+};
 
 class Value {
 public:
     typedef std::vector<std::string> StringList;
+    struct KeyLess {
+        typedef void is_transparent;
+
+        bool operator()(const std::string& left, const std::string& right) const;
+        bool operator()(const std::string& left, const Key& right) const;
+        bool operator()(const Key& left, const std::string& right) const;
+    };
+    typedef std::map<std::string, Value, KeyLess> Members;
+    typedef std::vector<Value> Elements;
     enum Type {Object, Array, Integer, Boolean, Real, String, Null};
 
+    struct ParseError {
+        enum Code {None, UnexpectedEnd, UnexpectedCharacter, InvalidLiteral, InvalidNumber,
+                    InvalidEscape, InvalidCodepoint, NestingTooDeep, OutOfMemory, TypeMismatch,
+                    MissingField};
+
+        ParseError();
+        const char* message() const;
+
+        Code code;
+        size_t offset;
+    };
+
+    struct FormatOptions {
+        enum Unicode {EscapeBmp, RawUtf8, AsciiOnly};
+        enum KeyOrder {ByteOrder, Utf16Order};
+        enum NumberFormat {Decimals, EcmaScript};
+
+        explicit FormatOptions(int indentWidth=-1);
+        static FormatOptions canonical();
+
+        int indent;
+        char indentCharacter;
+        bool escapeSlash;
+        Unicode unicode;
+        KeyOrder keyOrder;
+        NumberFormat numberFormat;
+        unsigned threads;
+        size_t minimumChunk; // fewest top-level items worth a thread of their own
+    };
+
+    struct MergePolicy {
+        enum Arrays {Replace, Append, ByKey};
+        enum Conflicts {OverlayWins, TargetWins, Fail};
+
+        explicit MergePolicy(Arrays arrayPolicy=Replace, Conflicts conflictPolicy=OverlayWins);
+
+        Arrays arrays;
+        std::string arrayKey; // the member that identifies an element with ByKey
+        Conflicts conflicts;
+    };
+
     static Value parse(const std::string& jsonText, size_t* offset=nullptr);
+    static bool tryParse(const std::string& jsonText, Value& value, ParseError& error,
+                         size_t* offset=nullptr) noexcept;
+    static bool tryParse(const char* jsonText, size_t length, Value& value, ParseError& error,
+                         size_t* offset=nullptr) noexcept;
+    static Value& parseInto(const std::string& jsonText, Value& target, size_t* offset=nullptr);
+    static bool tryParseInto(const std::string& jsonText, Value& target, ParseError& error,
+                             size_t* offset=nullptr) noexcept;
+    static bool tryParseInto(const char* jsonText, size_t length, Value& target, ParseError& error,
+                             size_t* offset=nullptr) noexcept;
+    static Value parse(const std::string& jsonText, const Projection& projection, size_t* offset=nullptr);
+    static bool tryParse(const char* jsonText, size_t length, const Projection& projection, Value& value,
+                         ParseError& error, size_t* offset=nullptr) noexcept;
+    static Value parseParallel(const std::string& jsonText, unsigned threads=0, size_t* offset=nullptr);
+    static bool tryParseParallel(const char* jsonText, size_t length, unsigned threads, Value& value,
+                                 ParseError& error, size_t* offset=nullptr) noexcept;
+    static bool validate(const std::string& jsonText, ParseError* error=nullptr) noexcept;
+    static bool validate(const char* jsonText, size_t length, ParseError* error=nullptr) noexcept;
     static Value null();
     static Value array();
     static Value object();
@@ -43,6 +165,7 @@ public:
     Value(bool value);
     
     Value(const Value& other);
+    Value(Value&& other) noexcept;
     ~Value()=default;
 
     Type getType() const;
@@ -52,27 +175,83 @@ public:
     double real() const;
     std::string string() const;
     bool isNull() const;
+    bool tryBoolean(bool& value) const noexcept;
+    bool tryInteger(int64_t& value) const noexcept;
+    bool tryReal(double& value) const noexcept;
+    bool tryString(std::string& value) const;
+    const std::string& stringRef() const;
+#if __cplusplus >= 201703L
+    std::string_view stringView() const;
+#endif
+    bool asBoolean(bool defaultValue) const noexcept;
+    int64_t asInteger(int64_t defaultValue) const noexcept;
+    double asReal(double defaultValue) const noexcept;
+    const std::string& asString(const std::string& defaultValue) const noexcept;
+    const char* asString(const char* defaultValue) const noexcept;
     
     int count() const;
     StringList keys() const;
-    bool has(const std::string& key) const;
-    Value& get(const std::string& key);
-    const Value& get(const std::string& key) const;
+    const Members* members() const;
+    const Elements* elements() const;
+    bool has(const Key& key) const;
+    const Value* find(const Key& key) const;
+    Value* find(const Key& key);
+    const Value* find(size_t index) const;
+    Value* find(size_t index);
+    const Value& at(const Key& key) const;
+    Value& at(const Key& key);
+    const Value& at(size_t index) const;
+    Value& at(size_t index);
+    Value& get(const Key& key);
+    const Value& get(const Key& key) const;
     Value& get(size_t index);
     const Value& get(size_t index) const;
+    bool getOr(const Key& key, bool defaultValue) const noexcept;
+    int64_t getOr(const Key& key, int defaultValue) const noexcept;
+    int64_t getOr(const Key& key, int64_t defaultValue) const noexcept;
+    double getOr(const Key& key, double defaultValue) const noexcept;
+    const std::string& getOr(const Key& key, const std::string& defaultValue) const noexcept;
+    const char* getOr(const Key& key, const char* defaultValue) const noexcept;
+    const Value* resolve(const std::string& pointer) const;
+    Value* resolve(const std::string& pointer);
 
     std::string &format(std::string &buffer, int indent=-1, int indentLevel=0) const;
     std::string format(int indent=-1, int indentLevel=0) const;
+    size_t format(char* buffer, size_t size, int indent=-1, int indentLevel=0) const;
+    void format(Output& output, int indent=-1, int indentLevel=0) const;
+    size_t formattedSize(int indent=-1, int indentLevel=0) const;
+    std::string &format(std::string &buffer, const FormatOptions& options, int indentLevel=0) const;
+    std::string format(const FormatOptions& options, int indentLevel=0) const;
+    size_t format(char* buffer, size_t size, const FormatOptions& options, int indentLevel=0) const;
+    void format(Output& output, const FormatOptions& options, int indentLevel=0) const;
+    size_t formattedSize(const FormatOptions& options, int indentLevel=0) const;
 
     Value& clear();
     Value& erase(size_t start, size_t end=std::numeric_limits<size_t>::max());
-    Value& erase(const std::string& key);
+    Value& erase(const Key& key);
 
-    Value& set(const std::string& key, const Value& value);
+    Value& set(const Key& key, const Value& value);
+    Value& set(const Key& key, Value&& value);
     Value& append(const Value& value);
+    Value& append(Value&& value);
     Value& insert(const Value& value, size_t before=0);
+    Value& insert(Value&& value, size_t before=0);
+    Value& reserve(size_t count);
+    Value& extend(const Value& other);
+    Value& extend(Value&& other);
+    Value& splice(size_t before, Value& other, size_t start=0, size_t end=std::numeric_limits<size_t>::max());
+    void swap(Value& other) noexcept;
+    Value& applyPatch(const Value& patch);
+    Value& mergePatch(const Value& patch);
+    Value& merge(const Value& overlay, const MergePolicy& policy=MergePolicy());
+    Value& merge(Value&& overlay, const MergePolicy& policy=MergePolicy());
+    static Value diff(const Value& from, const Value& to);
+    FrozenValue freeze() const;
+    std::string canonical() const;
+    void canonical(Sink& sink) const;
 
     Value& operator=(const Value& other);
+    Value& operator=(Value&& other) noexcept;
     Value& operator=(int value);
     Value& operator=(int64_t value);
     Value& operator=(double value);
@@ -85,10 +264,11 @@ public:
     Value& operator-=(int value);
     Value& operator[](size_t index);
     const Value& operator[](size_t index) const;
-    Value& operator[](const std::string &key);
-    const Value& operator[](const std::string &key) const;
+    Value& operator[](const Key& key);
+    const Value& operator[](const Key& key) const;
     bool operator==(const Value &other) const;
     bool operator!=(const Value &other) const;
+    size_t hash() const;
 
     typedef std::unique_ptr<Instance> InstPtr;
     static size_t skipWhitespace(const std::string& text, size_t offset);
@@ -96,8 +276,196 @@ private:
     explicit Value(InstPtr instance);
     InstPtr _instance;
 
-    static void _parseWord(const std::string& text, const std::string& word, size_t& offset);
-    static Value _parseNumber(const std::string& text, size_t& offset);
+    static const Value& _null();
+
+    friend class Parser;
+    friend class Binary;
+};
+
+class Parser {
+public:
+    static const size_t MaximumDepth = 1024;
+    static const size_t MinimumChunk = 1 << 20;
+
+    Parser(const char* text, size_t length, size_t offset=0);
+
+    bool parse(Value& value);
+    bool parse(Value& value, const Projection& projection);
+    bool parseParallel(Value& value, unsigned threads, size_t minimumChunk=MinimumChunk);
+    bool parseInto(Value& value);
+    bool skip();
+    bool scan(size_t outerDepth=0);
+    bool enter(char close, bool& done);
+    bool next(char close, bool& done);
+    bool key(std::string* key);
+    bool literal(const char* word, size_t size);
+    bool number(bool& real);
+    bool fail(Value::ParseError::Code code);
+    bool fail(Value::ParseError::Code code, size_t offset);
+    bool more() const;
+    char current() const;
+    void advance(size_t count=1);
+    void skipWhitespace();
+    bool finish();
+    size_t offset() const;
+    size_t length() const;
+    const char* text() const;
+    const Value::ParseError& error() const;
+    bool strict() const;
+    void setStrict(bool enabled);
+
+    Parser(const Parser&)=delete;
+    Parser& operator=(const Parser&)=delete;
+private:
+    const char* _text;
+    size_t _length;
+    size_t _offset;
+    size_t _depth;
+    Value::ParseError _error;
+    bool _strict; // plain RFC 8259: no ECMAScript \u{...} escapes
+    Value::Elements _stack; // elements of the arrays being parsed, moved out when each array closes
+
+    static bool _isDigit(char character);
+    static bool _isWhitespace(char character);
+    bool _parseNumber(Value& value);
+    bool _project(Value& value, const Projection& projection, size_t node, bool& kept);
+    bool _parseRun(Value::StringList* names, Value::Elements& elements, char close, size_t stop, bool& done);
+
+    friend class Array;
+};
+
+class Output {
+public:
+    Output();
+    explicit Output(std::string& buffer);
+    Output(char* buffer, size_t size);
+    Output(Sink& sink, char* buffer, size_t size);
+
+    Output& append(const char* text, size_t size);
+    Output& append(const std::string& text);
+    Output& append(char character);
+    Output& append(size_t count, char character);
+    Output& indent(size_t count, char character);
+    Output& flush();
+    Output& tally(size_t size);
+    bool counting() const;
+    size_t size() const;
+
+    Output(const Output&)=delete;
+    Output& operator=(const Output&)=delete;
+private:
+    std::string* _string;
+    Sink* _sink;
+    char* _buffer;
+    size_t _capacity;
+    size_t _used;
+    size_t _size;
+};
+
+class Sink {
+public:
+    Sink()=default;
+    virtual ~Sink()=default;
+
+    virtual void write(const char* text, size_t size)=0;
+
+    Sink(const Sink&)=delete;
+    Sink& operator=(const Sink&)=delete;
+};
+
+class StringSink : public Sink {
+public:
+    explicit StringSink(std::string& buffer);
+    virtual ~StringSink() override {};
+
+    virtual void write(const char* text, size_t size) override;
+private:
+    std::string& _buffer;
+};
+
+class StreamSink : public Sink {
+public:
+    explicit StreamSink(std::ostream& stream);
+    virtual ~StreamSink() override {};
+
+    virtual void write(const char* text, size_t size) override;
+private:
+    std::ostream& _stream;
+};
+
+class FileSink : public Sink {
+public:
+    explicit FileSink(int descriptor);
+    virtual ~FileSink() override {};
+
+    virtual void write(const char* text, size_t size) override;
+private:
+    int _descriptor;
+};
+
+class CallbackSink : public Sink {
+public:
+    typedef std::function<void(const char* text, size_t size)> Callback;
+
+    explicit CallbackSink(const Callback& callback);
+    virtual ~CallbackSink() override {};
+
+    virtual void write(const char* text, size_t size) override;
+private:
+    Callback _callback;
+};
+
+class Writer {
+public:
+    static const size_t BufferSize = 4096;
+
+    explicit Writer(Sink& sink, int indent=-1);
+    Writer(Sink& sink, const Value::FormatOptions& options);
+    ~Writer();
+
+    Writer& beginObject();
+    Writer& endObject();
+    Writer& beginArray();
+    Writer& endArray();
+    Writer& key(const std::string& name);
+    Writer& key(const char* name, size_t length);
+    Writer& value(const Value& value);
+    Writer& value(const std::string& value);
+    Writer& value(const char* value);
+    Writer& value(int value);
+    Writer& value(int64_t value);
+    Writer& value(uint64_t value);
+    Writer& value(double value);
+    Writer& value(bool value);
+    Writer& null();
+    Writer& raw(const char* jsonText, size_t length);
+    Writer& raw(const std::string& jsonText);
+    template<class T>
+    Writer& bound(const T& object);
+    Writer& flush();
+    bool complete() const;
+    size_t size() const;
+
+    Writer(const Writer&)=delete;
+    Writer& operator=(const Writer&)=delete;
+private:
+    struct _Level {
+        char close;
+        size_t count;
+    };
+
+    char _buffer[BufferSize];
+    Output _output;
+    Value::FormatOptions _options;
+    std::vector<_Level> _levels;
+    bool _afterKey;
+    bool _complete;
+
+    void _beforeValue();
+    void _afterValue();
+    void _separate();
+    Writer& _begin(char open, char close);
+    Writer& _end(char close);
 };
 
 class Instance {
@@ -106,25 +474,43 @@ public:
     virtual ~Instance()=default;
 
     virtual Instance *clone() const=0;
-    virtual void format(std::string &buffer, int indent, int indentLevel) const=0;
+    virtual void format(Output& output, const Value::FormatOptions& options, int indentLevel) const=0;
     virtual bool equals(const Instance& other) const;
+    virtual size_t hash() const=0;
+
+    static size_t combine(size_t seed, size_t value);
+    template<class Item>
+    static void formatItems(Output& output, const Value::FormatOptions& options, int indentLevel, size_t count,
+                            char open, char close, const Item& item);
     virtual Value::Type getType() const=0;
 
     virtual bool boolean() const;
     virtual int64_t integer() const;
     virtual double real() const;
+    virtual bool tryInteger(int64_t& value) const;
+    virtual bool tryReal(double& value) const;
+    virtual bool tryBoolean(bool& value) const;
+    virtual const std::string* stringPointer() const;
     virtual std::string string() const;
     virtual int count() const;
     virtual Value::StringList keys() const;
-    virtual bool has(const std::string& key);
-    virtual Value& get(const std::string& key);
+    virtual const Value::Members* members() const;
+    virtual const Value::Elements* elements() const;
+    virtual bool has(const Key& key) const;
+    virtual const Value* find(const Key& key) const;
+    virtual const Value* find(size_t index) const;
+    virtual Value& get(const Key& key);
     virtual Value& get(size_t index);
     virtual void clear();
     virtual void erase(size_t start, size_t end);
-    virtual void erase(const std::string& key);
-    virtual void set(const std::string& key, const Value& value);
+    virtual void erase(const Key& key);
+    virtual void set(const Key& key, const Value& value);
     virtual void append(const Value& value);
     virtual void insert(const Value& value, size_t before);
+    virtual void reserve(size_t count);
+    virtual void splice(size_t before, Instance& other, size_t start, size_t end);
+    virtual bool reusable(char next) const;
+    virtual bool reparse(Parser& parser);
 
     Instance(const Instance&)=delete;
     Instance& operator=(const Instance&)=delete;
@@ -132,27 +518,43 @@ public:
 
 class String : public Instance {
 public:
-    static std::string parse(const std::string& text, size_t& offset);
+    static bool parse(Parser& parser, std::string* result);
 
     explicit String(const std::string& value);
     virtual ~String() override {};
 
     virtual Instance *clone() const override;
-    virtual void format(std::string &buffer, int indent, int indentLevel) const override;
-    void _formatCodepoint(std::string& buffer, size_t &i) const;
+    static void format(Output& output, const std::string& value, const Value::FormatOptions& options);
+    static void format(Output& output, const char* text, size_t length, const Value::FormatOptions& options);
+    static bool utf16Less(const std::string& left, const std::string& right);
+    static bool validUtf8(const char* text, size_t length);
+    virtual void format(Output& output, const Value::FormatOptions& options, int indentLevel) const override;
     virtual bool equals(const Instance& other) const override;
+    virtual size_t hash() const override;
     virtual Value::Type getType() const override;
+    virtual bool reusable(char next) const override;
+    virtual bool reparse(Parser& parser) override;
 
+    virtual const std::string* stringPointer() const override;
     virtual std::string string() const override;
 
     String(const String&)=delete;
     String& operator=(const String&)=delete;
 private:
     std::string _value;
-    static size_t _codepoint(const std::string &text, size_t &offset);
+    static size_t _codepoint(const char* text, size_t length, size_t &offset);
+    static void _formatCodepoint(Output& output, const char* text, size_t length, size_t &offset,
+                                 Value::FormatOptions::Unicode unicode);
+    static void _formatEscaped(Output& output, size_t unit);
+    static const char* _shortEscape(char character);
+    static size_t _formattedLength(const char* text, size_t length, const Value::FormatOptions& options);
+    static bool _decode(const char* text, size_t length, size_t& offset, size_t& codepoint);
+    static size_t _plainLength(const char* text, size_t length, bool slash=false);
     static std::string _utf8(size_t codepoint);   
-    static void _parseEscaped(const std::string& text, size_t& offset, std::string& result);
-    static void _parseEscapedUnicode(const std::string& text, size_t& offset, std::string& result);
+    static int _hexDigit(char character);
+    static bool _hexQuad(const char* text, size_t& value);
+    static bool _parseEscaped(Parser& parser, std::string* result);
+    static bool _parseEscapedUnicode(Parser& parser, std::string* result);
 };
 
 class Integer : public Instance {
@@ -161,11 +563,18 @@ public:
     virtual ~Integer() override {};
 
     virtual Instance *clone() const override;
-    virtual void format(std::string &buffer, int indent, int indentLevel) const override;
+    static void format(Output& output, int64_t value);
+    static void format(Output& output, uint64_t value);
+    static void format(Output& output, int64_t value, const Value::FormatOptions& options);
+    static void format(Output& output, uint64_t value, const Value::FormatOptions& options);
+    static size_t digits(uint64_t value);
+    virtual void format(Output& output, const Value::FormatOptions& options, int indentLevel) const override;
     virtual bool equals(const Instance& other) const override;
+    virtual size_t hash() const override;
     virtual Value::Type getType() const override;
 
     virtual int64_t integer() const override;
+    virtual bool tryInteger(int64_t& value) const override;
 
     Integer(const Integer&)=delete;
     Integer& operator=(const Integer&)=delete;
@@ -179,11 +588,19 @@ public:
     virtual ~Real() override {};
 
     virtual Instance *clone() const override;
-    virtual void format(std::string &buffer, int indent, int indentLevel) const override;
+    static void format(Output& output, double value);
+    static void format(Output& output, double value, const Value::FormatOptions& options);
+    static void formatShortest(Output& output, double value);
+    virtual void format(Output& output, const Value::FormatOptions& options, int indentLevel) const override;
     virtual bool equals(const Instance& other) const override;
+    virtual size_t hash() const override;
     virtual Value::Type getType() const override;
 
     virtual double real() const override;
+    virtual bool tryReal(double& value) const override;
+
+    static bool equal(double a, double b);
+    static size_t hash(double value);
 
     Real(const Real&)=delete;
     Real& operator=(const Real&)=delete;
@@ -191,17 +608,46 @@ private:
     double _value;
 };
 
+class Number : public Instance {
+public:
+    Number(const char* text, size_t size, bool real);
+    virtual ~Number() override {};
+
+    virtual Instance *clone() const override;
+    virtual void format(Output& output, const Value::FormatOptions& options, int indentLevel) const override;
+    virtual bool equals(const Instance& other) const override;
+    virtual size_t hash() const override;
+    virtual Value::Type getType() const override;
+    virtual bool reusable(char next) const override;
+    virtual bool reparse(Parser& parser) override;
+
+    virtual int64_t integer() const override;
+    virtual double real() const override;
+    virtual bool tryInteger(int64_t& value) const override;
+    virtual bool tryReal(double& value) const override;
+
+    Number(const Number&)=delete;
+    Number& operator=(const Number&)=delete;
+private:
+    std::string _text;
+    bool _real;
+};
+
 class Boolean : public Instance {
 public:
     explicit Boolean(const bool value);
     virtual ~Boolean() override {};
 
     virtual Instance *clone() const override;
-    virtual void format(std::string &buffer, int indent, int indentLevel) const override;
+    virtual void format(Output& output, const Value::FormatOptions& options, int indentLevel) const override;
     virtual bool equals(const Instance& other) const override;
+    virtual size_t hash() const override;
     virtual Value::Type getType() const override;
+    virtual bool reusable(char next) const override;
+    virtual bool reparse(Parser& parser) override;
 
     virtual bool boolean() const override;
+    virtual bool tryBoolean(bool& value) const override;
 
     Boolean(const Boolean&)=delete;
     Boolean& operator=(const Boolean&)=delete;
@@ -211,107 +657,813 @@ private:
 
 class Array : public Instance {
 public:
-    static Array* parse(const std::string& text, size_t& offset);
+    static Array* parse(Parser& parser);
 
     explicit Array(const std::vector<Value>& value);
     virtual ~Array() override {};
 
     virtual Instance *clone() const override;
-    virtual void format(std::string &buffer, int indent, int indentLevel) const override;
+    virtual void format(Output& output, const Value::FormatOptions& options, int indentLevel) const override;
     virtual bool equals(const Instance& other) const override;
+    virtual size_t hash() const override;
     virtual Value::Type getType() const override;
+    virtual bool reusable(char next) const override;
+    virtual bool reparse(Parser& parser) override;
 
     virtual int count() const override;
-    virtual Value& get(const std::string& key) override;
+    virtual const Value::Elements* elements() const override;
+    virtual const Value* find(const Key& key) const override;
+    virtual const Value* find(size_t index) const override;
+    virtual Value& get(const Key& key) override;
     virtual Value& get(size_t index) override;
     virtual void clear() override;
-    virtual void erase(const std::string& key) override;
+    virtual void erase(const Key& key) override;
     virtual void erase(size_t start, size_t end) override;
     virtual void append(const Value& value) override;
     virtual void insert(const Value& value, size_t before) override;
+    virtual void reserve(size_t count) override;
+    virtual void splice(size_t before, Instance& other, size_t start, size_t end) override;
 
     Array(const Array&)=delete;
     Array& operator=(const Array&)=delete;
 private:
-    std::vector<Value> _value;
+    Value::Elements _value;
 };
 
 class Object : public Instance {
 public:
-    static Object* parse(const std::string& text, size_t& offset);
+    static Object* parse(Parser& parser);
     
-    explicit Object(const std::map<std::string, Value>& value);
+    typedef Value::Members Map;
+
+    explicit Object(const Map& value);
     virtual ~Object() override {};
 
     virtual Instance *clone() const override;
-    virtual void format(std::string &buffer, int indent, int indentLevel) const override;
+    virtual void format(Output& output, const Value::FormatOptions& options, int indentLevel) const override;
     virtual bool equals(const Instance& other) const override;
+    virtual size_t hash() const override;
     virtual Value::Type getType() const override;
+    virtual bool reusable(char next) const override;
+    virtual bool reparse(Parser& parser) override;
 
     virtual int count() const override;
     virtual Value::StringList keys() const override;
-    virtual bool has(const std::string& key) override;
-    virtual Value& get(const std::string& key) override;
+    virtual const Value::Members* members() const override;
+    virtual bool has(const Key& key) const override;
+    virtual const Value* find(const Key& key) const override;
+    virtual const Value* find(size_t index) const override;
+    virtual Value& get(const Key& key) override;
     virtual Value& get(size_t index) override;
     virtual void clear() override;
-    virtual void erase(const std::string& key) override;
+    virtual void erase(const Key& key) override;
     virtual void erase(size_t start, size_t end) override;
-    virtual void set(const std::string& key, const Value& value) override;
+    virtual void set(const Key& key, const Value& value) override;
+    virtual void reserve(size_t count) override;
 
     Object(const Object&)=delete;
     Object& operator=(const Object&)=delete;
 private:
-    std::map<std::string, Value> _value;
+    Map _value;
+
+    Map::const_iterator _find(const Key& key) const;
+    Map::iterator _find(const Key& key);
+    template<class Members>
+    static auto _find(Members& members, const Key& key) -> decltype(members.begin());
+};
+
+template<class T> struct Fields;
+
+class Binding {
+public:
+    static const size_t MaximumFields = 64;
+
+    template<class T>
+    static void parse(const std::string& jsonText, T& object, size_t* offset=nullptr);
+    template<class T>
+    static bool tryParse(const std::string& jsonText, T& object, Value::ParseError& error,
+                         size_t* offset=nullptr) noexcept;
+    template<class T>
+    static bool tryParse(const char* jsonText, size_t length, T& object, Value::ParseError& error,
+                         size_t* offset=nullptr) noexcept;
+    template<class T>
+    static bool read(Parser& parser, T& object);
+    template<class T>
+    static std::string format(const T& object, const Value::FormatOptions& options=Value::FormatOptions(),
+                              int indentLevel=0);
+    template<class T>
+    static void format(Output& output, const T& object,
+                       const Value::FormatOptions& options=Value::FormatOptions(), int indentLevel=0);
+private:
+    class _FieldReader {
+    public:
+        _FieldReader(Parser& parser, const std::string& key, uint64_t& seen);
+
+        template<size_t N, class T>
+        bool field(const char (&name)[N], T& member);
+        template<size_t N, class T>
+        bool optional(const char (&name)[N], T& member);
+        bool matched() const;
+        bool success() const;
+    private:
+        Parser& _parser;
+        const std::string& _key;
+        uint64_t& _seen;
+        size_t _index;
+        bool _matched;
+        bool _success;
+
+        template<size_t N>
+        bool _match(const char (&name)[N]);
+    };
+
+    class _FieldChecker {
+    public:
+        explicit _FieldChecker(uint64_t seen);
+
+        template<size_t N, class T>
+        bool field(const char (&name)[N], T& member);
+        template<size_t N, class T>
+        bool optional(const char (&name)[N], T& member);
+        bool complete() const;
+    private:
+        uint64_t _seen;
+        size_t _index;
+        bool _complete;
+    };
+
+    struct _Field {
+        const char* name;
+        size_t length;
+        const void* member;
+        void (*write)(Output& output, const void* member, const Value::FormatOptions& options, int indentLevel);
+    };
+
+    class _FieldWriter {
+    public:
+        _FieldWriter();
+
+        template<size_t N, class T>
+        bool field(const char (&name)[N], const T& member);
+        template<size_t N, class T>
+        bool optional(const char (&name)[N], const T& member);
+        void write(Output& output, const Value::FormatOptions& options, int indentLevel);
+    private:
+        _Field _fields[MaximumFields];
+        size_t _count;
+    };
+
+    static bool _read(Parser& parser, bool& value);
+    static bool _read(Parser& parser, std::string& value);
+    static bool _read(Parser& parser, Value& value);
+    template<class T>
+    static bool _read(Parser& parser, std::vector<T>& value);
+    template<class T>
+    static bool _read(Parser& parser, std::map<std::string, T>& value);
+    template<class T>
+    static typename std::enable_if<std::is_integral<T>::value, bool>::type _read(Parser& parser, T& value);
+    template<class T>
+    static typename std::enable_if<std::is_floating_point<T>::value, bool>::type _read(Parser& parser, T& value);
+    template<class T>
+    static typename std::enable_if<std::is_class<T>::value, bool>::type _read(Parser& parser, T& object);
+    template<class T>
+    static bool _readInteger(Parser& parser, T& value, std::true_type isSigned);
+    template<class T>
+    static bool _readInteger(Parser& parser, T& value, std::false_type isSigned);
+    static bool _number(Parser& parser, bool allowReal, std::string& digits);
+    static void _write(Output& output, bool value, const Value::FormatOptions& options, int indentLevel);
+    static void _write(Output& output, const std::string& value, const Value::FormatOptions& options,
+                       int indentLevel);
+    static void _write(Output& output, const Value& value, const Value::FormatOptions& options,
+                       int indentLevel);
+    template<class T>
+    static void _write(Output& output, const std::vector<T>& value, const Value::FormatOptions& options,
+                       int indentLevel);
+    template<class T>
+    static void _write(Output& output, const std::map<std::string, T>& value,
+                       const Value::FormatOptions& options, int indentLevel);
+    template<class T>
+    static typename std::enable_if<std::is_integral<T>::value>::type
+    _write(Output& output, T value, const Value::FormatOptions& options, int indentLevel);
+    template<class T>
+    static typename std::enable_if<std::is_floating_point<T>::value>::type
+    _write(Output& output, T value, const Value::FormatOptions& options, int indentLevel);
+    template<class T>
+    static typename std::enable_if<std::is_class<T>::value>::type
+    _write(Output& output, const T& object, const Value::FormatOptions& options, int indentLevel);
+    template<class T>
+    static void _writeMember(Output& output, const void* member, const Value::FormatOptions& options,
+                             int indentLevel);
+    template<class T>
+    static bool _empty(const T& value);
+    static bool _empty(const std::string& value);
+    static bool _empty(const Value& value);
+    template<class T>
+    static bool _empty(const std::vector<T>& value);
+    template<class T>
+    static bool _empty(const std::map<std::string, T>& value);
+    static void _separate(Output& output, const Value::FormatOptions& options, int indentLevel, bool first);
+    static void _close(Output& output, char close, const Value::FormatOptions& options, int indentLevel);
+    static bool _mismatch(Parser& parser);
+};
+
+#define YAJSON_BIND(Type, ...) \
+    namespace yajson { \
+    template<> struct Fields<Type> { \
+        template<class Object, class Visitor> \
+        static void visit(Object& object, Visitor& visitor) { \
+            const bool visited[] = {__VA_ARGS__}; \
+            static_assert(sizeof(visited) <= yajson::Binding::MaximumFields * sizeof(bool), \
+                          "Too many fields bound for " #Type); \
+            (void)visited; \
+        } \
+    }; \
+    }
+#define YAJSON_FIELD(member) visitor.field(#member, object.member)
+#define YAJSON_FIELD_NAMED(name, member) visitor.field(name, object.member)
+#define YAJSON_OPTIONAL(member) visitor.optional(#member, object.member)
+
+class Binary {
+public:
+    enum Format {MessagePack, Cbor};
+
+    static std::string encode(const Value& value, Format format);
+    static void encode(Output& output, const Value& value, Format format);
+    static Value decode(const std::string& data, Format format, size_t* offset=nullptr);
+    static bool tryDecode(const std::string& data, Format format, Value& value, Value::ParseError& error,
+                          size_t* offset=nullptr) noexcept;
+    static bool tryDecode(const char* data, size_t size, Format format, Value& value,
+                          Value::ParseError& error, size_t* offset=nullptr) noexcept;
+    static bool read(Parser& parser, Format format, Value& value);
+private:
+    static void _writeMessagePack(Output& output, const Value& value);
+    static void _writeCbor(Output& output, const Value& value);
+    static void _writeMessagePackSize(Output& output, uint64_t size, unsigned fixed, uint64_t fixedLimit,
+                                      unsigned lead, size_t bytes);
+    static void _writeCborHeader(Output& output, unsigned major, uint64_t argument);
+    static void _writeBigEndian(Output& output, uint64_t value, size_t bytes);
+    static void _writeReal(Output& output, char lead, double value);
+    static uint64_t _wideInteger(const Value& value, bool& negative);
+    static bool _readMessagePack(Parser& parser, Value& value, size_t depth);
+    static bool _readMessagePackKey(Parser& parser, std::string& key);
+    static bool _readCbor(Parser& parser, Value& value, size_t depth);
+    static bool _readCborHeader(Parser& parser, unsigned& major, unsigned& info, uint64_t& argument);
+    static bool _readCborText(Parser& parser, unsigned info, uint64_t argument, std::string& text);
+    static bool _readCborKey(Parser& parser, std::string& key);
+    static bool _readByte(Parser& parser, unsigned& byte);
+    static bool _readBigEndian(Parser& parser, size_t bytes, uint64_t& value);
+    static bool _readText(Parser& parser, uint64_t size, std::string& text);
+    static bool _cborBreak(Parser& parser);
+    static void _unsigned(uint64_t value, Value& result);
+    static void _negative(uint64_t argument, Value& result);
+    static double _real(uint64_t bits, size_t bytes);
+};
+
+class Snapshot {
+public:
+    static const uint32_t Version = 1;
+
+    static std::string write(const Value& value);
+    static void write(Sink& sink, const Value& value);
+private:
+    // every slot is a tag byte and 8 payload bytes, little endian;
+    // text and containers store a 32-bit offset and a 32-bit length or count
+    enum _Tag {_NullTag, _FalseTag, _TrueTag, _IntegerTag, _RealTag, _StringTag, _NumberTag, _ArrayTag,
+                _ObjectTag};
+    static const size_t _RootSlot = 8;
+    static const size_t _SlotSize = 9;
+    static const size_t _EntrySize = 8 + _SlotSize;
+
+    typedef std::map<std::string, uint64_t> _Strings;
+
+    static void _slot(std::string& buffer, size_t position, const Value& value, _Strings& strings);
+    static uint64_t _text(std::string& buffer, const std::string& text, _Strings& strings);
+    static void _put(std::string& buffer, size_t position, uint64_t value, size_t bytes);
+    static uint64_t _reference(size_t offset, size_t size);
+
+    friend class SnapshotView;
+};
+
+class SnapshotView {
+public:
+    SnapshotView();
+    SnapshotView(const char* data, size_t size);
+
+    Value::Type getType() const;
+    bool is(Value::Type valueType) const;
+    bool isNull() const;
+    bool boolean() const;
+    int64_t integer() const;
+    double real() const;
+    std::string string() const;
+    const char* stringData() const;
+    size_t stringSize() const;
+#if __cplusplus >= 201703L
+    std::string_view stringView() const;
+#endif
+    int count() const;
+    Value::StringList keys() const;
+    Key key(size_t index) const;
+    SnapshotView member(size_t index) const;
+    bool has(const Key& key) const;
+    SnapshotView at(const Key& key) const;
+    SnapshotView at(size_t index) const;
+    SnapshotView operator[](const Key& key) const;
+    SnapshotView operator[](size_t index) const;
+    Value value() const;
+private:
+    const char* _data;
+    size_t _size;
+    size_t _slot;
+
+    SnapshotView(const char* data, size_t size, size_t slot);
+    unsigned _tag() const;
+    uint64_t _payload() const;
+    size_t _record(unsigned tag, size_t entrySize) const;
+    Key _text(size_t position) const;
+    bool _find(const Key& key, size_t& index) const;
+    Key _string() const;
+    void _fill(Value& target, size_t depth) const;
+    static uint64_t _read(const char* data, size_t bytes);
+};
+
+class Pointer {
+public:
+    static bool split(const std::string& pointer, Value::StringList& tokens);
+    static std::string& append(std::string& pointer, const Key& token);
+    static bool index(const std::string& token, size_t& index);
+    template<class V>
+    static V* resolve(V& root, const Value::StringList& tokens, size_t count);
+};
+
+class Projection {
+public:
+    Projection();
+    Projection(std::initializer_list<std::string> pointers);
+    explicit Projection(const Value::StringList& pointers);
+
+    Projection& add(const std::string& pointer);
+    bool empty() const;
+private:
+    struct _Node {
+        _Node();
+
+        std::map<std::string, size_t, Value::KeyLess> children;
+        bool whole;
+    };
+
+    std::vector<_Node> _nodes; // _nodes[0] is the document
+
+    friend class Parser;
+};
+
+class Patch {
+public:
+    static const size_t MaximumArrayCost = 1000000;
+
+    static void apply(Value& target, const Value& patch);
+    static void merge(Value& target, const Value& patch);
+    static void merge(Value& target, Value&& overlay, const Value::MergePolicy& policy);
+    static Value diff(const Value& from, const Value& to, size_t maximumArrayCost=MaximumArrayCost);
+private:
+    // undo record: Restore puts back an overwritten value, Remove takes out an added one and
+    // Reinsert puts back a removed one (or the value the previous undo step took out)
+    struct _Change {
+        enum Kind {Restore, Remove, Reinsert};
+
+        Kind kind;
+        Value::StringList path;
+        Value value;
+        bool carried;
+    };
+    typedef std::vector<_Change> _Log;
+    typedef std::unordered_map<const Value*, size_t> _Hashes;
+
+    static bool _operation(Value& root, const Value& operation, _Log& log, std::string& error);
+    static bool _add(Value& root, const Value::StringList& path, Value& value, _Log& log, std::string& error);
+    static bool _remove(Value& root, const Value::StringList& path, Value& removed, std::string& error);
+    static void _merge(Value& target, const Value& patch, Value::StringList& path, _Log& log);
+    static bool _layer(Value& target, Value& overlay, const Value::MergePolicy& policy, std::string& path,
+                       bool apply);
+    static bool _layerByKey(Value& target, Value& overlay, const Value::MergePolicy& policy, std::string& path,
+                            bool apply);
+    static void _record(_Log& log, _Change::Kind kind, const Value::StringList& path, Value& value,
+                        bool carried=false);
+    static void _rollback(Value& root, _Log& log);
+    static bool _fail(std::string& error, const char* message);
+    static void _diff(const Value& from, const Value& to, std::string& path, size_t maximumArrayCost,
+                      _Hashes& hashes, Value& patch);
+    static void _diffArray(const Value& fromArray, const Value& toArray, std::string& path,
+                           size_t maximumArrayCost, _Hashes& hashes, Value& patch);
+    static size_t _hash(const Value& value, _Hashes& hashes);
+    static bool _same(const Value& left, const Value& right, _Hashes& hashes);
+    static void _emit(Value& patch, const char* op, const std::string& path, const Value* value);
+};
+
+class Cursor {
+public:
+    static const size_t BufferSize = 65536;
+
+    explicit Cursor(std::istream& stream, size_t bufferSize=BufferSize);
+
+    bool enter();
+    bool next();
+    bool read(Value& value);
+    bool read(Value& value, const Projection& projection);
+    bool skip();
+    const std::string& key() const;
+    bool done() const;
+    bool failed() const;
+    size_t offset() const;
+    const Value::ParseError& error() const;
+
+    Cursor(const Cursor&)=delete;
+    Cursor& operator=(const Cursor&)=delete;
+private:
+    std::istream& _stream;
+    size_t _bufferSize;
+    std::string _buffer;
+    size_t _start;
+    size_t _discarded;
+    std::vector<char> _levels;
+    std::string _key;
+    bool _first;
+    bool _pending;
+    bool _end;
+    Value::ParseError _error;
+
+    bool _fill();
+    char _peek();
+    bool _span(size_t& end);
+    bool _read(Value& value, const Projection* projection);
+    bool _finish();
+    bool _fail(Value::ParseError::Code code, size_t offset);
+};
+
+class FrozenValue : private SnapshotView {
+public:
+    FrozenValue();
+    explicit FrozenValue(const Value& value);
+
+    using SnapshotView::getType;
+    using SnapshotView::is;
+    using SnapshotView::isNull;
+    using SnapshotView::boolean;
+    using SnapshotView::integer;
+    using SnapshotView::real;
+    using SnapshotView::string;
+    using SnapshotView::stringData;
+    using SnapshotView::stringSize;
+#if __cplusplus >= 201703L
+    using SnapshotView::stringView;
+#endif
+    using SnapshotView::count;
+    using SnapshotView::keys;
+    using SnapshotView::key;
+    using SnapshotView::has;
+    using SnapshotView::value;
+    FrozenValue member(size_t index) const;
+    FrozenValue at(const Key& key) const;
+    FrozenValue at(size_t index) const;
+    FrozenValue operator[](const Key& key) const;
+    FrozenValue operator[](size_t index) const;
+    const SnapshotView& view() const;
+    const char* data() const;
+    size_t size() const;
+private:
+    std::shared_ptr<const std::string> _buffer;
+
+    explicit FrozenValue(const std::shared_ptr<const std::string>& buffer);
+    FrozenValue(const SnapshotView& view, const std::shared_ptr<const std::string>& buffer);
+};
+
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    const char* data() const;
+    size_t size() const;
+    SnapshotView snapshot() const;
+
+    MappedFile(const MappedFile&)=delete;
+    MappedFile& operator=(const MappedFile&)=delete;
+private:
+#ifdef _WIN32
+    std::string _contents;
+#else
+    void* _mapping;
+#endif
+    size_t _size;
 };
 
-#define YaJsonAssert(expression) if (!(expression)) {throw std::invalid_argument("Failed: " #expression);} else
+#ifdef YAJSON_NO_EXCEPTIONS
+#define YaJsonThrow(exception) std::abort()
+#else
+#define YaJsonThrow(exception) throw exception
+#endif
+#define YaJsonAssert(expression) if (!(expression)) {YaJsonThrow(std::invalid_argument("Failed: " #expression));} else
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wempty-body"
 
-inline Value Value::parse(const std::string& jsonText, size_t* position) {
-    Value value;
-    size_t offset = nullptr == position ? 0 : *position;
+inline Key::Key(const char* text)
+    :_data(text), _size(::strlen(text)) {}
 
-    offset = skipWhitespace(jsonText, offset);
-    YaJsonAssert(offset < jsonText.size());
-    
-    switch (jsonText[offset]) {
-        case '{': 
-            value._instance = InstPtr(Object::parse(jsonText, offset));
-            break;
-        case '[':
-            value._instance = InstPtr(Array::parse(jsonText, offset));
-            break;
-        case '"':
-            value = String::parse(jsonText, offset);
-            break;
-        case 't':
-            _parseWord(jsonText, "true", offset);
-            value = true;
-            break;
-        case 'f':
-            _parseWord(jsonText, "false", offset);
-            value = false;
-            break;
-        case 'n':
-            _parseWord(jsonText, "null", offset);
-            break;
+inline Key::Key(const char* text, size_t size)
+    :_data(text), _size(size) {}
+
+inline Key::Key(const std::string& text)
+    :_data(text.data()), _size(text.size()) {}
+
+#if __cplusplus >= 201703L
+inline Key::Key(std::string_view text)
+    :_data(text.data()), _size(text.size()) {}
+#endif
+
+inline const char* Key::data() const {
+    return _data;
+}
+
+inline size_t Key::size() const {
+    return _size;
+}
+
+inline std::string Key::string() const {
+    return std::string(_data, _size);
+}
+
+inline int Key::compare(const std::string& other) const {
+    const auto common = std::min(_size, other.size());
+    const int result = (common > 0) ? ::memcmp(_data, other.data(), common) : 0;
+
+    if (result != 0) {
+        return result;
+    }
+
+    return (_size < other.size()) ? -1 : ((_size > other.size()) ? 1 : 0);
+}
+
+inline bool Value::KeyLess::operator()(const std::string& left, const std::string& right) const {
+    return left < right;
+}
+
+inline bool Value::KeyLess::operator()(const std::string& left, const Key& right) const {
+    return right.compare(left) > 0;
+}
+
+inline bool Value::KeyLess::operator()(const Key& left, const std::string& right) const {
+    return left.compare(right) < 0;
+}
+
+inline Value::ParseError::ParseError()
+    :code(None), offset(0) {}
+
+inline const char* Value::ParseError::message() const {
+    switch (code) {
+        case None:
+            return "No error";
+        case UnexpectedEnd:
+            return "Unexpected end of text";
+        case UnexpectedCharacter:
+            return "Unexpected character";
+        case InvalidLiteral:
+            return "Invalid literal";
+        case InvalidNumber:
+            return "Invalid number";
+        case InvalidEscape:
+            return "Invalid escape";
+        case InvalidCodepoint:
+            return "Invalid codepoint";
+        case NestingTooDeep:
+            return "Nesting too deep";
+        case OutOfMemory:
+            return "Out of memory";
+        case TypeMismatch:
+            return "Type mismatch";
+        case MissingField:
+            return "Missing field";
         default:
-            value = _parseNumber(jsonText, offset);
-            break;
+            return "Unknown error";
     }
+}
+
+inline Value::FormatOptions::FormatOptions(int indentWidth)
+    :indent(indentWidth), indentCharacter(' '), escapeSlash(true), unicode(EscapeBmp),
+     keyOrder(ByteOrder), numberFormat(Decimals), threads(1), minimumChunk(1024) {}
+
+inline Value::FormatOptions Value::FormatOptions::canonical() {
+    FormatOptions options;
+
+    options.escapeSlash = false;
+    options.unicode = RawUtf8;
+    options.keyOrder = Utf16Order;
+    options.numberFormat = EcmaScript;
+    return options;
+}
 
-    if (nullptr != position) {
-        *position = offset;
+inline Value::MergePolicy::MergePolicy(Arrays arrayPolicy, Conflicts conflictPolicy)
+    :arrays(arrayPolicy), arrayKey(), conflicts(conflictPolicy) {}
+
+inline Value Value::parse(const std::string& jsonText, size_t* position) {
+    Value value;
+    ParseError error;
+
+    if (!tryParse(jsonText, value, error, position)) {
+        YaJsonThrow(std::invalid_argument(std::string(error.message()) + " at offset "
+                                            + std::to_string(error.offset)));
     }
 
     return value;
 }
 
+inline bool Value::tryParse(const std::string& jsonText, Value& value, ParseError& error,
+                            size_t* position) noexcept {
+    return tryParse(jsonText.data(), jsonText.size(), value, error, position);
+}
+
+inline bool Value::tryParse(const char* jsonText, size_t length, Value& value, ParseError& error,
+                            size_t* position) noexcept {
+    Parser parser(jsonText, length, nullptr == position ? 0 : *position);
+    Value result;
+    bool success = false;
+
+#ifdef YAJSON_NO_EXCEPTIONS
+    success = parser.parse(result);
+#else
+    try {
+        success = parser.parse(result);
+    } catch (const std::bad_alloc&) {
+        parser.fail(ParseError::OutOfMemory);
+    }
+#endif
+
+    success = success && ((nullptr != position) || parser.finish());
+    error = parser.error();
+
+    if (success) {
+        value._instance.swap(result._instance);
+
+        if (nullptr != position) {
+            *position = parser.offset();
+        }
+    }
+
+    return success;
+}
+
+inline Value& Value::parseInto(const std::string& jsonText, Value& target, size_t* position) {
+    ParseError error;
+
+    if (!tryParseInto(jsonText, target, error, position)) {
+        YaJsonThrow(std::invalid_argument(std::string(error.message()) + " at offset "
+                                            + std::to_string(error.offset)));
+    }
+
+    return target;
+}
+
+inline bool Value::tryParseInto(const std::string& jsonText, Value& target, ParseError& error,
+                                size_t* position) noexcept {
+    return tryParseInto(jsonText.data(), jsonText.size(), target, error, position);
+}
+
+inline bool Value::tryParseInto(const char* jsonText, size_t length, Value& target, ParseError& error,
+                                size_t* position) noexcept {
+    Parser parser(jsonText, length, nullptr == position ? 0 : *position);
+    bool success = false;
+
+#ifdef YAJSON_NO_EXCEPTIONS
+    success = parser.parseInto(target);
+#else
+    try {
+        success = parser.parseInto(target);
+    } catch (const std::bad_alloc&) {
+        parser.fail(ParseError::OutOfMemory);
+    }
+#endif
+
+    success = success && ((nullptr != position) || parser.finish());
+    error = parser.error();
+
+    if (!success) {
+        target._instance.reset(); // partially reused, so the contents are meaningless
+    } else if (nullptr != position) {
+        *position = parser.offset();
+    }
+
+    return success;
+}
+
+inline bool Value::validate(const std::string& jsonText, ParseError* error) noexcept {
+    return validate(jsonText.data(), jsonText.size(), error);
+}
+
+inline bool Value::validate(const char* jsonText, size_t length, ParseError* error) noexcept {
+    Parser parser(jsonText, length);
+
+    parser.setStrict(true);
+
+    const bool success = parser.skip() && parser.finish();
+
+    if (nullptr != error) {
+        *error = parser.error();
+    }
+
+    return success;
+}
+
 inline Value Value::null() {
     return Value();
 }
 
+inline Value Value::parse(const std::string& jsonText, const Projection& projection, size_t* position) {
+    Value value;
+    ParseError error;
+
+    if (!tryParse(jsonText.data(), jsonText.size(), projection, value, error, position)) {
+        YaJsonThrow(std::invalid_argument(std::string(error.message()) + " at offset "
+                                            + std::to_string(error.offset)));
+    }
+
+    return value;
+}
+
+inline bool Value::tryParse(const char* jsonText, size_t length, const Projection& projection, Value& value,
+                            ParseError& error, size_t* position) noexcept {
+    Parser parser(jsonText, length, nullptr == position ? 0 : *position);
+    Value result;
+    bool success = false;
+
+#ifdef YAJSON_NO_EXCEPTIONS
+    success = parser.parse(result, projection);
+#else
+    try {
+        success = parser.parse(result, projection);
+    } catch (const std::bad_alloc&) {
+        parser.fail(ParseError::OutOfMemory);
+    }
+#endif
+
+    success = success && ((nullptr != position) || parser.finish());
+    error = parser.error();
+
+    if (success) {
+        value._instance.swap(result._instance);
+
+        if (nullptr != position) {
+            *position = parser.offset();
+        }
+    }
+
+    return success;
+}
+
+inline Value Value::parseParallel(const std::string& jsonText, unsigned threads, size_t* position) {
+    Value value;
+    ParseError error;
+
+    if (!tryParseParallel(jsonText.data(), jsonText.size(), threads, value, error, position)) {
+        YaJsonThrow(std::invalid_argument(std::string(error.message()) + " at offset "
+                                            + std::to_string(error.offset)));
+    }
+
+    return value;
+}
+
+inline bool Value::tryParseParallel(const char* jsonText, size_t length, unsigned threads, Value& value,
+                                    ParseError& error, size_t* position) noexcept {
+    Parser parser(jsonText, length, nullptr == position ? 0 : *position);
+    Value result;
+    bool success = false;
+
+    if (0 == threads) {
+        threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+#ifdef YAJSON_NO_EXCEPTIONS
+    success = parser.parseParallel(result, threads);
+#else
+    try {
+        success = parser.parseParallel(result, threads);
+    } catch (const std::bad_alloc&) {
+        parser.fail(ParseError::OutOfMemory);
+    }
+#endif
+
+    success = success && ((nullptr != position) || parser.finish());
+    error = parser.error();
+
+    if (success) {
+        value._instance.swap(result._instance);
+
+        if (nullptr != position) {
+            *position = parser.offset();
+        }
+    }
+
+    return success;
+}
+
 inline Value Value::array() {
     return Value(std::unique_ptr<Instance>(new yajson::Array({})));
 }
@@ -360,6 +1512,9 @@ inline Value::Value(const Value& other)
     }
 }
 
+inline Value::Value(Value&& other) noexcept
+    :_instance(std::move(other._instance)) {}
+
 inline bool Value::boolean() const {
     return isNull() ? false : _instance->boolean();
 }
@@ -388,37 +1543,183 @@ inline bool Value::isNull() const {
     return nullptr == _instance;
 }
 
-inline int Value::count() const {
-    return isNull() ? 0 : _instance->count();
-}
-
-inline Value::StringList Value::keys() const {
-    return isNull() ? StringList() : _instance->keys();
+inline bool Value::tryBoolean(bool& value) const noexcept {
+    return !isNull() && _instance->tryBoolean(value);
 }
 
-inline bool Value::has(const std::string& key) const {
-    return isNull() ? false : _instance->has(key);
-}
+inline bool Value::tryInteger(int64_t& value) const noexcept {
+    int64_t result = 0;
 
-inline Value& Value::get(const std::string& key) {
-    if (isNull()) {
-        throw std::domain_error("null");
+    if (isNull() || !_instance->tryInteger(result)) {
+        return false;
     }
 
-    return _instance->get(key);
+    value = result;
+    return true;
 }
 
-inline const Value& Value::get(const std::string& key) const {
-    if (isNull()) {
-        throw std::domain_error("null");
+inline bool Value::tryReal(double& value) const noexcept {
+    double result = 0.0;
+
+    if (isNull() || !_instance->tryReal(result)) {
+        return false;
+    }
+
+    value = result;
+    return true;
+}
+
+inline bool Value::tryString(std::string& value) const {
+    const auto text = isNull() ? nullptr : _instance->stringPointer();
+
+    if (nullptr == text) {
+        return false;
+    }
+
+    value = *text;
+    return true;
+}
+
+inline const std::string& Value::stringRef() const {
+    static const std::string empty;
+    const auto text = isNull() ? &empty : _instance->stringPointer();
+
+    if (nullptr == text) {
+        YaJsonThrow(std::domain_error("wrong type"));
+    }
+
+    return *text;
+}
+
+#if __cplusplus >= 201703L
+inline std::string_view Value::stringView() const {
+    return stringRef();
+}
+#endif
+
+inline bool Value::asBoolean(bool defaultValue) const noexcept {
+    bool result = defaultValue;
+
+    return tryBoolean(result) ? result : defaultValue;
+}
+
+inline int64_t Value::asInteger(int64_t defaultValue) const noexcept {
+    int64_t result = defaultValue;
+
+    return tryInteger(result) ? result : defaultValue;
+}
+
+inline double Value::asReal(double defaultValue) const noexcept {
+    double result = defaultValue;
+
+    return tryReal(result) ? result : defaultValue;
+}
+
+inline const std::string& Value::asString(const std::string& defaultValue) const noexcept {
+    const auto text = isNull() ? nullptr : _instance->stringPointer();
+
+    return nullptr == text ? defaultValue : *text;
+}
+
+inline const char* Value::asString(const char* defaultValue) const noexcept {
+    const auto text = isNull() ? nullptr : _instance->stringPointer();
+
+    return nullptr == text ? defaultValue : text->c_str();
+}
+
+inline int Value::count() const {
+    return isNull() ? 0 : _instance->count();
+}
+
+inline Value::StringList Value::keys() const {
+    return isNull() ? StringList() : _instance->keys();
+}
+
+inline const Value::Members* Value::members() const {
+    return isNull() ? nullptr : _instance->members();
+}
+
+inline const Value::Elements* Value::elements() const {
+    return isNull() ? nullptr : _instance->elements();
+}
+
+inline bool Value::has(const Key& key) const {
+    return isNull() ? false : _instance->has(key);
+}
+
+inline const Value* Value::find(const Key& key) const {
+    return isNull() ? nullptr : _instance->find(key);
+}
+
+inline Value* Value::find(const Key& key) {
+    return const_cast<Value*>(static_cast<const Value*>(this)->find(key));
+}
+
+inline const Value* Value::find(size_t index) const {
+    return isNull() ? nullptr : _instance->find(index);
+}
+
+inline Value* Value::find(size_t index) {
+    return const_cast<Value*>(static_cast<const Value*>(this)->find(index));
+}
+
+inline const Value& Value::at(const Key& key) const {
+    if (isNull()) {
+        YaJsonThrow(std::domain_error("null"));
+    }
+
+    const auto found = _instance->find(key);
+
+    if (nullptr == found) {
+        YaJsonThrow(std::out_of_range("missing key: " + key.string()));
+    }
+
+    return *found;
+}
+
+inline Value& Value::at(const Key& key) {
+    return const_cast<Value&>(static_cast<const Value*>(this)->at(key));
+}
+
+inline const Value& Value::at(size_t index) const {
+    if (isNull()) {
+        YaJsonThrow(std::domain_error("null"));
+    }
+
+    const auto found = _instance->find(index);
+
+    if (nullptr == found) {
+        YaJsonThrow(std::out_of_range("index out of range: " + std::to_string(index)));
+    }
+
+    return *found;
+}
+
+inline Value& Value::at(size_t index) {
+    return const_cast<Value&>(static_cast<const Value*>(this)->at(index));
+}
+
+inline Value& Value::get(const Key& key) {
+    if (isNull()) {
+        YaJsonThrow(std::domain_error("null"));
     }
 
     return _instance->get(key);
 }
 
+inline const Value& Value::get(const Key& key) const {
+    if (isNull()) {
+        YaJsonThrow(std::domain_error("null"));
+    }
+
+    const auto found = _instance->find(key);
+
+    return nullptr == found ? _null() : *found;
+}
+
 inline Value& Value::get(size_t index) {
     if (isNull()) {
-        throw std::domain_error("null");
+        YaJsonThrow(std::domain_error("null"));
     }
 
     return _instance->get(index);
@@ -426,25 +1727,126 @@ inline Value& Value::get(size_t index) {
 
 inline const Value& Value::get(size_t index) const {
     if (isNull()) {
-        throw std::domain_error("null");
+        YaJsonThrow(std::domain_error("null"));
     }
 
-    return _instance->get(index);
+    const auto found = _instance->find(index);
+
+    return nullptr == found ? _null() : *found;
 }
 
-inline std::string &Value::format(std::string &buffer, int indent, int indentLevel) const {
-    if (isNull()) {
-        return buffer = "null";
+inline const Value* Value::resolve(const std::string& pointer) const {
+    StringList tokens;
+
+    if (!Pointer::split(pointer, tokens)) {
+        YaJsonThrow(std::invalid_argument("invalid JSON pointer: " + pointer));
     }
 
-    _instance->format(buffer, indent, indentLevel);
-    return buffer;
+    return Pointer::resolve(*this, tokens, tokens.size());
+}
+
+inline Value* Value::resolve(const std::string& pointer) {
+    StringList tokens;
+
+    if (!Pointer::split(pointer, tokens)) {
+        YaJsonThrow(std::invalid_argument("invalid JSON pointer: " + pointer));
+    }
+
+    return Pointer::resolve(*this, tokens, tokens.size());
+}
+
+inline bool Value::getOr(const Key& key, bool defaultValue) const noexcept {
+    const auto found = is(Object) ? find(key) : nullptr;
+
+    return nullptr == found ? defaultValue : found->asBoolean(defaultValue);
+}
+
+inline int64_t Value::getOr(const Key& key, int defaultValue) const noexcept {
+    return getOr(key, static_cast<int64_t>(defaultValue));
+}
+
+inline int64_t Value::getOr(const Key& key, int64_t defaultValue) const noexcept {
+    const auto found = is(Object) ? find(key) : nullptr;
+
+    return nullptr == found ? defaultValue : found->asInteger(defaultValue);
+}
+
+inline double Value::getOr(const Key& key, double defaultValue) const noexcept {
+    const auto found = is(Object) ? find(key) : nullptr;
+
+    return nullptr == found ? defaultValue : found->asReal(defaultValue);
+}
+
+inline const std::string& Value::getOr(const Key& key, const std::string& defaultValue) const noexcept {
+    const auto found = is(Object) ? find(key) : nullptr;
+
+    return nullptr == found ? defaultValue : found->asString(defaultValue);
+}
+
+inline const char* Value::getOr(const Key& key, const char* defaultValue) const noexcept {
+    const auto found = is(Object) ? find(key) : nullptr;
+
+    return nullptr == found ? defaultValue : found->asString(defaultValue);
+}
+
+inline std::string &Value::format(std::string &buffer, int indent, int indentLevel) const {
+    return format(buffer, FormatOptions(indent), indentLevel);
 }
 
 inline std::string Value::format(int indent, int indentLevel) const {
+    return format(FormatOptions(indent), indentLevel);
+}
+
+inline size_t Value::format(char* buffer, size_t size, int indent, int indentLevel) const {
+    return format(buffer, size, FormatOptions(indent), indentLevel);
+}
+
+inline void Value::format(Output& output, int indent, int indentLevel) const {
+    format(output, FormatOptions(indent), indentLevel);
+}
+
+inline size_t Value::formattedSize(int indent, int indentLevel) const {
+    return formattedSize(FormatOptions(indent), indentLevel);
+}
+
+inline std::string &Value::format(std::string &buffer, const FormatOptions& options, int indentLevel) const {
+    buffer.clear();
+    buffer.reserve(formattedSize(options, indentLevel));
+
+    Output output(buffer);
+
+    format(output, options, indentLevel);
+    return buffer;
+}
+
+inline std::string Value::format(const FormatOptions& options, int indentLevel) const {
     std::string buffer;
 
-    return format(buffer, indent, indentLevel);
+    return format(buffer, options, indentLevel);
+}
+
+inline size_t Value::format(char* buffer, size_t size, const FormatOptions& options, int indentLevel) const {
+    Output output(buffer, size);
+
+    format(output, options, indentLevel);
+    return output.size();
+}
+
+inline void Value::format(Output& output, const FormatOptions& options, int indentLevel) const {
+    if (isNull()) {
+        output.append("null", 4);
+    } else {
+        _instance->format(output, options, indentLevel);
+    }
+}
+
+inline size_t Value::formattedSize(const FormatOptions& options, int indentLevel) const {
+    FormatOptions serial(options);
+    Output counter;
+
+    serial.threads = 1;
+    format(counter, serial, indentLevel);
+    return counter.size();
 }
 
 inline Value& Value::clear() {
@@ -457,34 +1859,43 @@ inline Value& Value::clear() {
 
 inline Value& Value::erase(size_t start, size_t end) {
     if (isNull()) {
-        throw std::domain_error("null");
+        YaJsonThrow(std::domain_error("null"));
     }
 
     _instance->erase(start, end);
     return *this;
 }
 
-inline Value& Value::erase(const std::string& key) {
+inline Value& Value::erase(const Key& key) {
     if (isNull()) {
-        throw std::domain_error("null");
+        YaJsonThrow(std::domain_error("null"));
     }
 
     _instance->erase(key);
     return *this;
 }
 
-inline Value& Value::set(const std::string& key, const Value& value) {
+inline Value& Value::set(const Key& key, const Value& value) {
     if (isNull()) {
-        throw std::domain_error("null");
+        YaJsonThrow(std::domain_error("null"));
     }
 
     _instance->set(key, value);
     return *this;
 }
 
+inline Value& Value::set(const Key& key, Value&& value) {
+    if (isNull()) {
+        YaJsonThrow(std::domain_error("null"));
+    }
+
+    _instance->get(key) = std::move(value);
+    return *this;
+}
+
 inline Value& Value::append(const Value& value) {
     if (isNull()) {
-        throw std::domain_error("null");
+        YaJsonThrow(std::domain_error("null"));
     }
 
     _instance->append(value);
@@ -493,13 +1904,114 @@ inline Value& Value::append(const Value& value) {
 
 inline Value& Value::insert(const Value& value, size_t before) {
     if (isNull()) {
-        throw std::domain_error("null");
+        YaJsonThrow(std::domain_error("null"));
     }
 
     _instance->insert(value, before);
     return *this;    
 }
 
+inline Value& Value::append(Value&& value) {
+    if (isNull()) {
+        YaJsonThrow(std::domain_error("null"));
+    }
+
+    _instance->append(Value());
+    _instance->get(static_cast<size_t>(_instance->count()) - 1) = std::move(value);
+    return *this;
+}
+
+inline Value& Value::insert(Value&& value, size_t before) {
+    if (isNull()) {
+        YaJsonThrow(std::domain_error("null"));
+    }
+
+    const auto size = static_cast<size_t>(_instance->count());
+
+    _instance->insert(Value(), before);
+    _instance->get(std::min(before, size)) = std::move(value);
+    return *this;
+}
+
+inline FrozenValue Value::freeze() const {
+    return FrozenValue(*this);
+}
+
+inline std::string Value::canonical() const {
+    return format(FormatOptions::canonical());
+}
+
+inline void Value::canonical(Sink& sink) const {
+    Writer writer(sink, FormatOptions::canonical());
+
+    writer.value(*this).flush();
+}
+
+inline Value& Value::reserve(size_t count) {
+    if (isNull()) {
+        YaJsonThrow(std::domain_error("null"));
+    }
+
+    _instance->reserve(count);
+    return *this;
+}
+
+inline Value& Value::extend(const Value& other) {
+    Value elements(other);
+
+    return extend(std::move(elements));
+}
+
+inline Value& Value::extend(Value&& other) {
+    return splice(std::numeric_limits<size_t>::max(), other);
+}
+
+inline Value& Value::splice(size_t before, Value& other, size_t start, size_t end) {
+    if (isNull()) {
+        YaJsonThrow(std::domain_error("null"));
+    }
+
+    if (!other.isNull()) {
+        _instance->splice(before, *other._instance, start, end);
+    }
+
+    return *this;
+}
+
+inline void Value::swap(Value& other) noexcept {
+    _instance.swap(other._instance);
+}
+
+inline Value& Value::applyPatch(const Value& patch) {
+    Patch::apply(*this, patch);
+    return *this;
+}
+
+inline Value& Value::mergePatch(const Value& patch) {
+    Patch::merge(*this, patch);
+    return *this;
+}
+
+inline Value& Value::merge(const Value& overlay, const MergePolicy& policy) {
+    Value copy(overlay);
+
+    return merge(std::move(copy), policy);
+}
+
+inline Value& Value::merge(Value&& overlay, const MergePolicy& policy) {
+    Patch::merge(*this, std::move(overlay), policy);
+    return *this;
+}
+
+inline Value Value::diff(const Value& from, const Value& to) {
+    return Patch::diff(from, to);
+}
+
+inline Value& Value::operator=(Value&& other) noexcept {
+    _instance = std::move(other._instance);
+    return *this;
+}
+
 inline Value& Value::operator=(const Value& other) {
     if (!other.isNull()) {
         _instance = InstPtr(other._instance->clone());
@@ -564,11 +2076,11 @@ inline const Value& Value::operator[](size_t index) const {
     return get(index);
 }
 
-inline Value& Value::operator[](const std::string &key) {
+inline Value& Value::operator[](const Key& key) {
     return get(key);
 }
 
-inline const Value& Value::operator[](const std::string &key) const {
+inline const Value& Value::operator[](const Key& key) const {
     return get(key);
 }
 
@@ -581,746 +2093,5479 @@ inline bool Value::operator==(const Value &other) const {
         return false;
     }
 
-    return _instance->equals(*other._instance) && other._instance->equals(*_instance);
+    return _instance->equals(*other._instance);
 }
 
 inline bool Value::operator!=(const Value &other) const {
     return !(*this == other);
 }
 
+inline size_t Value::hash() const {
+    return isNull() ? Instance::combine(Null, 0) : _instance->hash();
+}
+
 inline Value::Value(InstPtr instance)
     :_instance(std::move(instance)) {}
 
-inline size_t Value::skipWhitespace(const std::string& text, size_t offset) {
-    while ((offset < text.length()) && ::isspace(text[offset])) {
-        offset += 1;
-    }
+inline const Value& Value::_null() {
+    static const Value null; // shared by const lookups of missing keys and indices
 
-    return offset;
+    return null;
 }
 
-inline void Value::_parseWord(const std::string& text, const std::string& word, size_t& offset) {
-    const auto actual = text.substr(offset, word.length());
-    
-    if (actual != word) {
-        throw std::invalid_argument("Invalid word: " + actual);
-    }
+inline size_t Value::skipWhitespace(const std::string& text, size_t offset) {
+    Parser parser(text.data(), text.length(), offset);
 
-    offset += word.length();
+    parser.skipWhitespace();
+    return parser.offset();
 }
 
-inline Value Value::_parseNumber(const std::string& text, size_t& offset) {
-    std::string integerChars("-+0123456789");
-    std::string realChars("Ee.");
-    bool hasRealChar = false;
-    const std::string::size_type start = offset;
-    size_t after = 0;
-    Value value;
+inline Parser::Parser(const char* text, size_t length, size_t offset)
+    :_text(text), _length(length), _offset(offset), _depth(0), _error(), _strict(false), _stack() {}
+
+inline bool Parser::parse(Value& value) {
+    bool success = false;
 
-    while ( (offset < text.length()) 
-            && ( (integerChars.find(text[offset]) != std::string::npos) 
-                || (realChars.find(text[offset]) != std::string::npos) ) ) {
-        hasRealChar = hasRealChar 
-                        || (realChars.find(text[offset]) != std::string::npos);
-        offset += 1;
+    skipWhitespace();
+
+    if (!more()) {
+        return fail(Value::ParseError::UnexpectedEnd);
     }
 
-    YaJsonAssert(start < offset);
+    switch (current()) {
+        case '{': {
+            const auto object = Object::parse(*this);
 
-    if (hasRealChar) {
-        try {
-            value = std::stod(text.substr(start, offset - start), &after);
-        } catch (const std::exception &exception) {
-            throw std::invalid_argument(std::string("Illegal Number: ")
-                                    + text.substr(start, offset - start));
+            success = (nullptr != object);
+            value._instance = Value::InstPtr(object);
+            break;
         }
-    } else {
-        try {
-            const auto converted = std::stoll(text.substr(start, offset - start), &after);
+        case '[': {
+            const auto array = Array::parse(*this);
+
+            success = (nullptr != array);
+            value._instance = Value::InstPtr(array);
+            break;
+        }
+        case '"': {
+            std::string text;
 
-            value = static_cast<int64_t>(converted);
-        } catch (const std::exception &exception) {
-            throw std::invalid_argument(std::string("Illegal Number: ")
-                                        + text.substr(start, offset - start));
+            success = String::parse(*this, &text);
+            value = text;
+            break;
         }
+        case 't':
+            success = literal("true", 4);
+            value = true;
+            break;
+        case 'f':
+            success = literal("false", 5);
+            value = false;
+            break;
+        case 'n':
+            success = literal("null", 4);
+            value._instance = nullptr;
+            break;
+        default:
+            success = _parseNumber(value);
+            break;
     }
 
-    YaJsonAssert(after == offset - start);
-    return value;
+    return success;
 }
 
-inline bool Instance::boolean() const {
-    throw std::domain_error("wrong type");
-}
+inline bool Parser::parse(Value& value, const Projection& projection) {
+    bool kept = false;
 
-inline bool Instance::equals(const Instance& other) const {
-    return getType() == other.getType();
-}
+    skipWhitespace();
 
-inline int64_t Instance::integer() const {
-    throw std::domain_error("wrong type");
-}
+    const bool container = more() && (('{' == current()) || ('[' == current()));
 
-inline double Instance::real() const {
-    throw std::domain_error("wrong type");
-}
+    if (!_project(value, projection, 0, kept)) {
+        return false;
+    }
 
-inline std::string Instance::string() const {
-    throw std::domain_error("wrong type");
-}
+    if (!kept && !container) { // the top-level object or array is returned even when empty
+        value._instance = nullptr;
+    }
 
-inline int Instance::count() const {
-    throw std::domain_error("wrong type");
+    return true;
 }
 
-inline Value::StringList Instance::keys() const {
-    throw std::domain_error("wrong type");
-}
+// chunks are scanned for both guesses of starting inside a string; chaining them in order settles which holds
+inline bool Parser::parseParallel(Value& value, unsigned threads, size_t minimumChunk) {
+    struct Guess {
+        Guess() :depth(0), commas() {}
+
+        long depth;
+        std::vector<size_t> commas; // commas[n]: first comma n levels above the chunk start, or npos
+    };
+    struct Scan {
+        Scan() :quoted(false), guesses() {}
+
+        bool quoted;
+        Guess guesses[2]; // [0]: the chunk starts outside a string, [1]: inside one
+    };
+    struct Run {
+        Run() :names(), elements(), end(0), done(false), success(false), error() {}
+
+        Value::StringList names;
+        Value::Elements elements;
+        size_t end;
+        bool done;
+        bool success;
+        Value::ParseError error;
+    };
+    const auto launch = std::launch::async | std::launch::deferred;
+
+    skipWhitespace();
+
+    if (!more()) {
+        return fail(Value::ParseError::UnexpectedEnd);
+    }
 
-inline bool Instance::has(const std::string& /*key*/) {
-    throw std::domain_error("wrong type");
-}
+    const char open = _text[_offset];
+    const char close = ('[' == open) ? ']' : '}';
+    const size_t size = _length - _offset;
+    const size_t chunks = std::min(static_cast<size_t>(std::max(threads, 1u)), size / std::max(minimumChunk, size_t(1)));
 
-inline Value& Instance::get(const std::string& /*key*/) {
-    throw std::domain_error("wrong type");
-}
+    if ((('[' != open) && ('{' != open)) || (chunks < 2)) {
+        return parse(value);
+    }
 
-inline Value& Instance::get(size_t /*index*/) {
-    throw std::domain_error("wrong type");
-}
+    std::vector<size_t> starts(1, _offset);
 
-inline void Instance::clear() {
-    throw std::domain_error("wrong type");
-}
+    for (size_t chunk = 1; chunk < chunks; ++chunk) {
+        size_t start = _offset + size / chunks * chunk;
 
-inline void Instance::erase(size_t /*start*/, size_t /*end*/) {
-    throw std::domain_error("wrong type");
-}
+        while ((start < _length) && ('\\' == _text[start - 1])) {
+            start += 1;
+        }
 
-inline void Instance::erase(const std::string& /*key*/) {
-    throw std::domain_error("wrong type");
-}
+        if ((start > starts.back()) && (start < _length)) {
+            starts.push_back(start);
+        }
+    }
 
-inline void Instance::set(const std::string& /*key*/, const Value& /*value*/) {
-    throw std::domain_error("wrong type");
-}
+    starts.push_back(_length);
+
+    std::vector<Scan> scans(starts.size() - 1);
+    std::vector<std::future<void>> scanning;
+
+    for (size_t chunk = 0; chunk < scans.size(); ++chunk) {
+        scanning.push_back(std::async(launch, [this, &starts, &scans, chunk]() {
+            Scan& scan = scans[chunk];
+
+            for (size_t i = starts[chunk]; i < starts[chunk + 1]; ++i) {
+                Guess& guess = scan.guesses[scan.quoted ? 1 : 0]; // the guess under which this is not string text
+
+                switch (_text[i]) {
+                    case '\\':
+                        i += 1;
+                        break;
+                    case '"':
+                        scan.quoted = !scan.quoted;
+                        break;
+                    case '[':
+                    case '{':
+                        guess.depth += 1;
+                        break;
+                    case ']':
+                    case '}':
+                        guess.depth -= 1;
+                        break;
+                    case ',':
+                        if (guess.depth <= 0) {
+                            const auto above = static_cast<size_t>(-guess.depth);
+
+                            if (guess.commas.size() <= above) {
+                                guess.commas.resize(above + 1, std::string::npos);
+                            }
+
+                            if (std::string::npos == guess.commas[above]) {
+                                guess.commas[above] = i;
+                            }
+                        }
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }));
+    }
 
-inline void Instance::append(const Value& /*value*/) {
-    throw std::domain_error("wrong type");
-}
+    for (auto& scan : scanning) {
+        scan.get();
+    }
 
-inline void Instance::insert(const Value& /*value*/, size_t /*before*/) {
-    throw std::domain_error("wrong type");
+    std::vector<size_t> splits; // top-level commas the runs start after
+    bool quoted = false;
+    long depth = 0;
+
+    for (const auto& scan : scans) {
+        const Guess& guess = scan.guesses[quoted ? 1 : 0];
+
+        if ((depth >= 1) && (static_cast<size_t>(depth - 1) < guess.commas.size())
+                && (std::string::npos != guess.commas[static_cast<size_t>(depth - 1)])) {
+            splits.push_back(guess.commas[static_cast<size_t>(depth - 1)]);
+        }
+
+        depth += guess.depth;
+        quoted = (quoted != scan.quoted);
+    }
+
+    std::vector<Run> runs(splits.size() + 1);
+    std::vector<std::future<void>> parsing;
+    const auto parseRun = [this, &splits, &runs, close](size_t index) {
+        Run& run = runs[index];
+        Parser parser(_text, _length, (0 == index) ? _offset : splits[index - 1] + 1);
+        const size_t stop = (index < splits.size()) ? splits[index] : _length;
+
+        if (0 == index) {
+            parser._depth = _depth;
+            run.success = parser.enter(close, run.done);
+        } else {
+            parser._depth = _depth + 1;
+            run.success = true;
+        }
+
+        run.success = run.success && (run.done
+                        || parser._parseRun((']' == close) ? nullptr : &run.names, run.elements, close, stop, run.done));
+        run.end = parser._offset;
+        run.error = parser._error;
+    };
+
+    for (size_t index = 1; index < runs.size(); ++index) {
+        parsing.push_back(std::async(launch, parseRun, index));
+    }
+
+    parseRun(0);
+
+    for (auto& run : parsing) {
+        run.get();
+    }
+
+    Value result = (']' == close) ? Value::array() : Value::object();
+    size_t index = 0;
+    bool done = false;
+
+    while (true) {
+        Run& run = runs[index];
+
+        _offset = run.end;
+
+        if (!run.success) {
+            return fail(run.error.code, run.error.offset);
+        }
+
+        for (size_t i = 0; i < run.elements.size(); ++i) {
+            if (']' == close) {
+                result.append(std::move(run.elements[i]));
+            } else {
+                result.set(run.names[i], std::move(run.elements[i]));
+            }
+        }
+
+        done = run.done;
+        index += 1;
+
+        if (done || (index >= runs.size()) || (splits[index - 1] != run.end)) {
+            break;
+        }
+    }
+
+    if (!done) { // a run overran its split, which the scan rules out; stay correct regardless
+        _offset = starts.front();
+        return parse(value);
+    }
+
+    value.swap(result);
+    return true;
 }
 
-inline std::string String::parse(const std::string& text, size_t& offset) {
-    std::string result;
+// stops at the first separating comma at or after stop, leaving the offset there and done unset
+inline bool Parser::_parseRun(Value::StringList* names, Value::Elements& elements, char close, size_t stop,
+                              bool& done) {
+    done = false;
 
-    offset += 1; // skip open quote
+    while (!done) {
+        elements.push_back(Value());
 
-    do {
-        YaJsonAssert(offset < text.length());
+        if (nullptr != names) {
+            names->push_back(std::string());
+            skipWhitespace();
 
-        switch (text[offset]) {
-            case '\\':
-                _parseEscaped(text, offset, result);
-                break;
+            if (!key(&names->back())) {
+                return false;
+            }
+        }
 
-            case '"':
-                break;
+        if (!parse(elements.back())) {
+            return false;
+        }
 
-            default:
-                result += text[offset];
-                offset += 1;
-                break;
+        skipWhitespace();
+
+        if (more() && (',' == _text[_offset]) && (_offset >= stop)) {
+            return true;
         }
 
-        YaJsonAssert(offset < text.length());
-    } while ('"' != text[offset]);
+        if (!next(close, done)) {
+            return false;
+        }
+    }
 
-    YaJsonAssert(offset < text.length());
-    YaJsonAssert('"' == text[offset]);
-    offset += 1; // skip end quote
-    return result;
+    return true;
 }
 
-inline String::String(const std::string& value)
-    :_value(value) {}
+inline bool Parser::parseInto(Value& value) {
+    skipWhitespace();
 
-inline Instance *String::clone() const {
-    return new String(_value);
+    if (!more()) {
+        return fail(Value::ParseError::UnexpectedEnd);
+    }
+
+    if (!value.isNull() && value._instance->reusable(current())) {
+        return value._instance->reparse(*this);
+    }
+
+    return parse(value);
 }
 
-inline void String::format(std::string &buffer, int /*indent*/, int /*indentLevel*/) const {
-    buffer = "\"";
+inline bool Parser::skip() {
+    bool success = false;
+    bool done = false;
+    bool real = false;
 
-    for (std::string::size_type i = 0; i < _value.length(); ++i) {
-        switch (_value[i]) {
-            case '\\':
-                buffer += "\\\\";
-                break;
-            case '"':
-                buffer += "\\\"";
-                break;
-            case '/':
-                buffer += "\\/";
-                break;
-            case '\t':
-                buffer += "\\t";
-                break;
-            case '\r':
-                buffer += "\\r";
+    skipWhitespace();
+
+    if (!more()) {
+        return fail(Value::ParseError::UnexpectedEnd);
+    }
+
+    switch (current()) {
+        case '{':
+            success = enter('}', done);
+
+            while (success && !done) {
+                success = key(nullptr) && skip() && next('}', done);
+            }
+            break;
+        case '[':
+            success = enter(']', done);
+
+            while (success && !done) {
+                success = skip() && next(']', done);
+            }
+            break;
+        case '"':
+            success = String::parse(*this, nullptr);
+            break;
+        case 't':
+            success = literal("true", 4);
+            break;
+        case 'f':
+            success = literal("false", 5);
+            break;
+        case 'n':
+            success = literal("null", 4);
+            break;
+        default:
+            success = number(real);
+            break;
+    }
+
+    return success;
+}
+
+inline bool Parser::scan(size_t outerDepth) {
+    uint64_t objects[MaximumDepth / 64] = {}; // one bit per open container: set for objects
+    size_t depth = 0;
+
+    skipWhitespace();
+
+    if (!more()) {
+        return fail(Value::ParseError::UnexpectedEnd);
+    }
+
+    do {
+        const char character = _text[_offset];
+
+        switch (character) {
+            case '[':
+            case '{':
+                if (outerDepth + depth >= MaximumDepth) {
+                    return fail(Value::ParseError::NestingTooDeep);
+                }
+
+                if ('{' == character) {
+                    objects[depth / 64] |= uint64_t(1) << (depth % 64);
+                } else {
+                    objects[depth / 64] &= ~(uint64_t(1) << (depth % 64));
+                }
+
+                depth += 1;
+                _offset += 1;
                 break;
-            case '\n':
-                buffer += "\\n";
+            case ']':
+            case '}':
+                if ((0 == depth) || (('}' == character) != (((objects[(depth - 1) / 64] >> ((depth - 1) % 64)) & 1) != 0))) {
+                    return fail(Value::ParseError::UnexpectedCharacter);
+                }
+
+                depth -= 1;
+                _offset += 1;
                 break;
-            case '\b':
-                buffer += "\\b";
+            case '"':
+                _offset += 1;
+
+                while ((_offset < _length) && ('"' != _text[_offset])) {
+                    _offset += ('\\' == _text[_offset]) ? 2 : 1;
+                }
+
+                if (_offset >= _length) {
+                    return fail(Value::ParseError::UnexpectedEnd, _length);
+                }
+
+                _offset += 1; // skip "
                 break;
-            case '\f':
-                buffer += "\\f";
+            case ',':
+            case ':':
+                if (0 == depth) {
+                    return fail(Value::ParseError::UnexpectedCharacter);
+                }
+
+                _offset += 1;
                 break;
             default:
-                _formatCodepoint(buffer, i);
+                if (_isWhitespace(character)) {
+                    _offset += 1;
+                    break;
+                }
+
+                // a literal or number runs to the next structural character; it is not checked here
+                do {
+                    _offset += 1;
+                } while ((_offset < _length) && (nullptr == ::strchr(",:[]{}\" \t\r\n", _text[_offset])));
                 break;
         }
+    } while ((depth > 0) && (_offset < _length));
+
+    return (0 == depth) || fail(Value::ParseError::UnexpectedEnd);
+}
+
+// kept is false when the value holds nothing the projection asks for
+inline bool Parser::_project(Value& value, const Projection& projection, size_t node, bool& kept) {
+    const Projection::_Node& entry = projection._nodes[node];
+    Value result;
+    bool success = false;
+    bool done = false;
+
+    skipWhitespace();
+
+    if (!more()) {
+        return fail(Value::ParseError::UnexpectedEnd);
+    }
+
+    if (entry.whole) {
+        kept = true;
+        return parse(value);
+    }
+
+    switch (current()) {
+        case '{': {
+            std::string name;
+
+            result = Value::object();
+            success = enter('}', done);
+
+            while (success && !done) {
+                name.clear();
+                success = key(&name);
+
+                const auto found = success ? entry.children.find(name) : entry.children.end();
+
+                if (entry.children.end() == found) {
+                    success = success && scan(_depth);
+                } else {
+                    Value member;
+                    bool keep = false;
+
+                    success = _project(member, projection, found->second, keep);
+
+                    if (success && keep) {
+                        result.set(name, std::move(member));
+                    }
+                }
+
+                success = success && next('}', done);
+            }
+            break;
+        }
+        case '[':
+            result = Value::array();
+            success = enter(']', done);
+
+            while (success && !done) {
+                Value element;
+                bool keep = false;
+
+                success = _project(element, projection, node, keep);
+
+                if (success && keep) {
+                    result.append(std::move(element));
+                }
+
+                success = success && next(']', done);
+            }
+            break;
+        default:
+            kept = false;
+            return scan(_depth);
+    }
+
+    kept = result.count() > 0;
+    value.swap(result);
+    return success;
+}
+
+inline bool Parser::enter(char close, bool& done) {
+    _offset += 1; // skip [ or {
+    _depth += 1;
+
+    if (_depth > MaximumDepth) {
+        return fail(Value::ParseError::NestingTooDeep);
     }
 
-    buffer += "\"";
+    skipWhitespace();
+
+    if (!more()) {
+        return fail(Value::ParseError::UnexpectedEnd);
+    }
+
+    done = (close == _text[_offset]);
+
+    if (done) {
+        _offset += 1; // skip ] or }
+        _depth -= 1;
+    }
+
+    return true;
 }
 
-inline void String::_formatCodepoint(std::string &buffer, size_t &i) const
-{
-    auto offset = i;
-    const auto codepoint = _codepoint(_value, offset);
+inline bool Parser::next(char close, bool& done) {
+    skipWhitespace();
+
+    if (!more()) {
+        return fail(Value::ParseError::UnexpectedEnd);
+    }
 
-    if (offset - i == 1) { // single character, just copy it across
-        buffer += _value[i];
+    if (',' == _text[_offset]) {
+        _offset += 1; // skip ,
+        skipWhitespace();
+        done = false;
+    } else if (close == _text[_offset]) {
+        _offset += 1; // skip ] or }
+        _depth -= 1;
+        done = true;
     } else {
-        const bool ecma6 = (codepoint > 0xFFFF); // u{xxxxxx} not supported before ecma6
-        std::stringstream stream;
+        return fail(Value::ParseError::UnexpectedCharacter);
+    }
 
-        if (ecma6) { // just copy the value across, since escaping may not be supported
-            buffer = buffer + _value.substr(i, offset - i);
-        } else {
-            buffer = buffer + "\\u";
-            stream << std::setfill('0') << std::setw(4) << std::hex << codepoint;
-            buffer = buffer + stream.str();
+    return true;
+}
+
+inline bool Parser::key(std::string* key) {
+    if (!more()) {
+        return fail(Value::ParseError::UnexpectedEnd);
+    }
+
+    if ('"' != _text[_offset]) {
+        return fail(Value::ParseError::UnexpectedCharacter);
+    }
+
+    if (!String::parse(*this, key)) {
+        return false;
+    }
+
+    skipWhitespace();
+
+    if (!more()) {
+        return fail(Value::ParseError::UnexpectedEnd);
+    }
+
+    if (':' != _text[_offset]) {
+        return fail(Value::ParseError::UnexpectedCharacter);
+    }
+
+    _offset += 1; // skip :
+    return true;
+}
+
+inline bool Parser::literal(const char* word, size_t size) {
+    if ((_length - _offset < size) || (::memcmp(_text + _offset, word, size) != 0)) {
+        return fail(Value::ParseError::InvalidLiteral);
+    }
+
+    _offset += size;
+    return true;
+}
+
+inline bool Parser::number(bool& real) {
+    const size_t start = _offset;
+
+    real = false;
+
+    if ('-' == current()) {
+        _offset += 1;
+    }
+
+    if ('0' == current()) {
+        _offset += 1;
+    } else if (_isDigit(current())) {
+        while (_isDigit(current())) {
+            _offset += 1;
+        }
+    } else {
+        return fail(start == _offset ? Value::ParseError::UnexpectedCharacter
+                                     : Value::ParseError::InvalidNumber, start);
+    }
+
+    if ('.' == current()) {
+        _offset += 1;
+        real = true;
+
+        if (!_isDigit(current())) {
+            return fail(Value::ParseError::InvalidNumber, start);
+        }
+
+        while (_isDigit(current())) {
+            _offset += 1;
+        }
+    }
+
+    if (('e' == current()) || ('E' == current())) {
+        _offset += 1;
+        real = true;
+
+        if (('+' == current()) || ('-' == current())) {
+            _offset += 1;
+        }
+
+        if (!_isDigit(current())) {
+            return fail(Value::ParseError::InvalidNumber, start);
+        }
+
+        while (_isDigit(current())) {
+            _offset += 1;
         }
     }
 
-    i = offset - 1;
+    return true;
 }
 
-inline bool String::equals(const Instance& other) const {
-    if (!Instance::equals(other)) {
+inline bool Parser::fail(Value::ParseError::Code code) {
+    return fail(code, _offset);
+}
+
+inline bool Parser::fail(Value::ParseError::Code code, size_t offset) {
+    _error.code = code;
+    _error.offset = offset;
+    return false;
+}
+
+inline bool Parser::more() const {
+    return _offset < _length;
+}
+
+inline char Parser::current() const {
+    return more() ? _text[_offset] : '\0';
+}
+
+inline void Parser::advance(size_t count) {
+    _offset += count;
+}
+
+inline void Parser::skipWhitespace() {
+    while (more() && _isWhitespace(_text[_offset])) {
+        _offset += 1;
+    }
+}
+
+inline bool Parser::finish() {
+    skipWhitespace();
+    return !more() || fail(Value::ParseError::UnexpectedCharacter);
+}
+
+inline size_t Parser::offset() const {
+    return _offset;
+}
+
+inline size_t Parser::length() const {
+    return _length;
+}
+
+inline const char* Parser::text() const {
+    return _text;
+}
+
+inline const Value::ParseError& Parser::error() const {
+    return _error;
+}
+
+inline bool Parser::strict() const {
+    return _strict;
+}
+
+inline void Parser::setStrict(bool enabled) {
+    _strict = enabled;
+}
+
+inline bool Parser::_isDigit(char character) {
+    return (character >= '0') && (character <= '9');
+}
+
+inline bool Parser::_isWhitespace(char character) {
+    return (' ' == character) || ('\n' == character) || ('\r' == character) || ('\t' == character);
+}
+
+inline bool Parser::_parseNumber(Value& value) {
+    const size_t start = _offset;
+    bool real = false;
+
+    if (!number(real)) {
         return false;
     }
 
-    return _value == dynamic_cast<const String*>(&other)->_value;
+    value._instance = Value::InstPtr(new Number(_text + start, _offset - start, real));
+    return true;
 }
 
-inline Value::Type String::getType() const {
-    return Value::String;
+inline Output::Output()
+    :_string(nullptr), _sink(nullptr), _buffer(nullptr), _capacity(0), _used(0), _size(0) {}
+
+inline Output::Output(std::string& buffer)
+    :_string(&buffer), _sink(nullptr), _buffer(nullptr), _capacity(0), _used(0), _size(0) {}
+
+inline Output::Output(char* buffer, size_t size)
+    :_string(nullptr), _sink(nullptr), _buffer(buffer), _capacity(size), _used(0), _size(0) {}
+
+inline Output::Output(Sink& sink, char* buffer, size_t size)
+    :_string(nullptr), _sink(&sink), _buffer(buffer), _capacity(size), _used(0), _size(0) {
+    YaJsonAssert(size > 0);
 }
 
-inline std::string String::string() const {
-    return _value;
+inline Output& Output::append(const char* text, size_t size) {
+    if (nullptr != _string) {
+        _string->append(text, size);
+    } else if (nullptr != _sink) {
+        if (_used + size > _capacity) {
+            flush();
+        }
+
+        if (size >= _capacity) { // too big to buffer, so hand it straight to the sink
+            _sink->write(text, size);
+        } else {
+            ::memcpy(_buffer + _used, text, size);
+            _used += size;
+        }
+    } else if (_size < _capacity) {
+        ::memcpy(_buffer + _size, text, std::min(size, _capacity - _size));
+    }
+
+    _size += size;
+    return *this;
 }
 
-inline size_t String::_codepoint(const std::string &text, std::string::size_type &offset) {
-    /*
-            1  7   U+0000   U+007F   0xxxxxxx
-            2  11  U+0080   U+07FF   110xxxxx  10xxxxxx
-            3  16  U+0800   U+FFFF   1110xxxx  10xxxxxx  10xxxxxx
-            4  21  U+10000  U+10FFFF 11110xxx  10xxxxxx  10xxxxxx  10xxxxxx
-    */
-    const bool oneByte = (offset < text.length()) && ((0x80 & text.data()[offset]) == 0);
-    const bool twoBytes = (offset + 1 < text.length()) && ((0xE0 & text.data()[offset]) == 0xC0);
-    const bool threeBytes = (offset + 2 < text.length()) && ((0xF0 & text.data()[offset]) == 0xE0);
-    const bool fourBytes = (offset + 3 < text.length()) && ((0xF8 & text.data()[offset]) == 0xF0);
-    size_t codepoint;
-
-    if (oneByte) {
-        offset += 1;
-        codepoint = text.data()[offset - 1] & 0xFF;
-        YaJsonAssert(codepoint <= 0x7F);
-    } else if (twoBytes) {
-        YaJsonAssert(offset + 2 <= text.length());
-        offset += 2;
-        codepoint = ((size_t(text.data()[offset - 2] & 0x1F) << 6)
-                    | size_t(text.data()[offset - 1] & 0x3F));
-        YaJsonAssert((text.data()[offset - 1] & 0xC0) == 0x80);
-        YaJsonAssert((codepoint > 0x7F) && (codepoint <= 0x7FF));
-    } else if (threeBytes) {
-        YaJsonAssert(offset + 3 <= text.length());
-        offset += 3;
-        codepoint = ((size_t(text.data()[offset - 3] & 0x0F) << 12)
-                  |  (size_t(text.data()[offset - 2] & 0x3F) << 6)
-                  |   size_t(text.data()[offset - 1] & 0x3F));
-        YaJsonAssert((text.data()[offset - 1] & 0xC0) == 0x80);
-        YaJsonAssert((text.data()[offset - 2] & 0xC0) == 0x80);
-        YaJsonAssert((codepoint > 0x7FF) && (codepoint <= 0xFFFF));
-    } else if (fourBytes) {
-        YaJsonAssert(offset + 4 <= text.length());
-        offset += 4;
-        codepoint = ((size_t(text.data()[offset - 4] & 0x07) << 18)
-                   | (size_t(text.data()[offset - 3] & 0x3F) << 12)
-                   | (size_t(text.data()[offset - 2] & 0x3F) << 6)
-                   |  size_t(text.data()[offset - 1] & 0x3F));
-        YaJsonAssert((text.data()[offset - 1] & 0xC0) == 0x80);
-        YaJsonAssert((text.data()[offset - 2] & 0xC0) == 0x80);
-        YaJsonAssert((text.data()[offset - 3] & 0xC0) == 0x80);
-        YaJsonAssert((codepoint > 0xFFFF) && (codepoint <= 0x10FFFF));
+inline Output& Output::append(const std::string& text) {
+    return append(text.data(), text.size());
+}
+
+inline Output& Output::append(char character) {
+    return append(&character, 1);
+}
+
+inline Output& Output::append(size_t count, char character) {
+    if (nullptr != _string) {
+        _string->append(count, character);
+    } else if (nullptr != _sink) {
+        for (size_t left = count; left > 0;) {
+            if (_used == _capacity) {
+                flush();
+            }
+
+            const auto chunk = std::min(left, _capacity - _used);
+
+            ::memset(_buffer + _used, character, chunk);
+            _used += chunk;
+            left -= chunk;
+        }
+    } else if (_size < _capacity) {
+        ::memset(_buffer + _size, character, std::min(count, _capacity - _size));
+    }
+
+    _size += count;
+    return *this;
+}
+
+inline Output& Output::indent(size_t count, char character) {
+    static const char spaces[] = "                                                                ";
+    static const char tabs[] = "\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t\t";
+    const char* const table = ('\t' == character) ? tabs : spaces;
+    const size_t tableSize = ('\t' == character) ? sizeof(tabs) - 1 : sizeof(spaces) - 1;
+
+    while (count > 0) {
+        const auto chunk = std::min(count, tableSize);
+
+        append(table, chunk);
+        count -= chunk;
+    }
+
+    return *this;
+}
+
+inline Output& Output::flush() {
+    if ((nullptr != _sink) && (_used > 0)) {
+        const auto used = _used;
+
+        _used = 0; // reset first so a throwing sink is not handed the same bytes again
+        _sink->write(_buffer, used);
+    }
+
+    return *this;
+}
+
+inline Output& Output::tally(size_t size) {
+    _size += size;
+    return *this;
+}
+
+inline bool Output::counting() const {
+    return (nullptr == _string) && (nullptr == _sink) && (_size >= _capacity);
+}
+
+inline size_t Output::size() const {
+    return _size;
+}
+
+inline StringSink::StringSink(std::string& buffer)
+    :_buffer(buffer) {}
+
+inline void StringSink::write(const char* text, size_t size) {
+    _buffer.append(text, size);
+}
+
+inline StreamSink::StreamSink(std::ostream& stream)
+    :_stream(stream) {}
+
+inline void StreamSink::write(const char* text, size_t size) {
+    _stream.write(text, static_cast<std::streamsize>(size));
+}
+
+inline FileSink::FileSink(int descriptor)
+    :_descriptor(descriptor) {}
+
+inline void FileSink::write(const char* text, size_t size) {
+    while (size > 0) {
+#ifdef _WIN32
+        const auto written = ::_write(_descriptor, text, static_cast<unsigned>(std::min<size_t>(size, 0x40000000)));
+#else
+        const auto written = ::write(_descriptor, text, size);
+#endif
+
+        if ((written < 0) && (EINTR == errno)) {
+            continue;
+        }
+
+        if (written <= 0) {
+            YaJsonThrow(std::runtime_error("write failed: " + std::to_string(errno)));
+        }
+
+        text += written;
+        size -= static_cast<size_t>(written);
+    }
+}
+
+inline CallbackSink::CallbackSink(const Callback& callback)
+    :_callback(callback) {}
+
+inline void CallbackSink::write(const char* text, size_t size) {
+    _callback(text, size);
+}
+
+inline Writer::Writer(Sink& sink, int indent)
+    :_buffer(), _output(sink, _buffer, BufferSize), _options(indent), _levels(), _afterKey(false),
+     _complete(false) {}
+
+inline Writer::Writer(Sink& sink, const Value::FormatOptions& options)
+    :_buffer(), _output(sink, _buffer, BufferSize), _options(options), _levels(), _afterKey(false),
+     _complete(false) {}
+
+inline Writer::~Writer() {
+    _output.flush();
+}
+
+inline Writer& Writer::beginObject() {
+    return _begin('{', '}');
+}
+
+inline Writer& Writer::endObject() {
+    return _end('}');
+}
+
+inline Writer& Writer::beginArray() {
+    return _begin('[', ']');
+}
+
+inline Writer& Writer::endArray() {
+    return _end(']');
+}
+
+inline Writer& Writer::key(const std::string& name) {
+    return key(name.data(), name.size());
+}
+
+inline Writer& Writer::key(const char* name, size_t length) {
+    YaJsonAssert(!_levels.empty() && ('}' == _levels.back().close) && !_afterKey);
+    _separate();
+    String::format(_output, name, length, _options);
+    _output.append(':');
+    _afterKey = true;
+    return *this;
+}
+
+inline Writer& Writer::value(const Value& value) {
+    _beforeValue();
+    value.format(_output, _options, static_cast<int>(_levels.size()));
+    _afterValue();
+    return *this;
+}
+
+inline Writer& Writer::value(const std::string& value) {
+    _beforeValue();
+    String::format(_output, value, _options);
+    _afterValue();
+    return *this;
+}
+
+inline Writer& Writer::value(const char* value) {
+    if (nullptr == value) {
+        return null();
+    }
+
+    _beforeValue();
+    String::format(_output, value, ::strlen(value), _options);
+    _afterValue();
+    return *this;
+}
+
+inline Writer& Writer::value(int value) {
+    return this->value(static_cast<int64_t>(value));
+}
+
+inline Writer& Writer::value(int64_t value) {
+    _beforeValue();
+    Integer::format(_output, value, _options);
+    _afterValue();
+    return *this;
+}
+
+inline Writer& Writer::value(uint64_t value) {
+    _beforeValue();
+    Integer::format(_output, value, _options);
+    _afterValue();
+    return *this;
+}
+
+inline Writer& Writer::value(double value) {
+    _beforeValue();
+    Real::format(_output, value, _options);
+    _afterValue();
+    return *this;
+}
+
+inline Writer& Writer::value(bool value) {
+    return raw(value ? "true" : "false", value ? 4 : 5);
+}
+
+inline Writer& Writer::null() {
+    return raw("null", 4);
+}
+
+inline Writer& Writer::raw(const char* jsonText, size_t length) {
+    _beforeValue();
+    _output.append(jsonText, length);
+    _afterValue();
+    return *this;
+}
+
+inline Writer& Writer::raw(const std::string& jsonText) {
+    return raw(jsonText.data(), jsonText.size());
+}
+
+template<class T>
+inline Writer& Writer::bound(const T& object) {
+    _beforeValue();
+    Binding::format(_output, object, _options, static_cast<int>(_levels.size()));
+    _afterValue();
+    return *this;
+}
+
+inline Writer& Writer::flush() {
+    _output.flush();
+    return *this;
+}
+
+inline bool Writer::complete() const {
+    return _complete;
+}
+
+inline size_t Writer::size() const {
+    return _output.size();
+}
+
+inline void Writer::_beforeValue() {
+    if (_levels.empty()) {
+        YaJsonAssert(!_complete);
+    } else if ('}' == _levels.back().close) {
+        YaJsonAssert(_afterKey);
+        _afterKey = false;
+    } else {
+        _separate();
+    }
+}
+
+inline void Writer::_afterValue() {
+    if (_levels.empty()) {
+        _complete = true;
+        _output.flush();
+    }
+}
+
+inline void Writer::_separate() {
+    auto& level = _levels.back();
+
+    if (level.count > 0) {
+        _output.append(',');
+    }
+
+    if (_options.indent >= 0) {
+        _output.append('\n');
+        _output.indent(static_cast<size_t>(_options.indent) * _levels.size(), _options.indentCharacter);
+    }
+
+    level.count += 1;
+}
+
+inline Writer& Writer::_begin(char open, char close) {
+    const _Level level = {close, 0};
+
+    _beforeValue();
+    _output.append(open);
+    _levels.push_back(level);
+    return *this;
+}
+
+inline Writer& Writer::_end(char close) {
+    YaJsonAssert(!_levels.empty() && (close == _levels.back().close) && !_afterKey);
+    _levels.pop_back();
+
+    if (_options.indent >= 0) {
+        _output.append('\n');
+        _output.indent(static_cast<size_t>(_options.indent) * _levels.size(), _options.indentCharacter);
+    }
+
+    _output.append(close);
+    _afterValue();
+    return *this;
+}
+
+template<class Item>
+inline void Instance::formatItems(Output& output, const Value::FormatOptions& options, int indentLevel,
+                                  size_t count, char open, char close, const Item& item) {
+    const bool lines = (options.indent >= 0);
+    const auto lastIndents = lines ? static_cast<size_t>(options.indent * indentLevel) : 0;
+    const auto indents = lines ? lastIndents + static_cast<size_t>(options.indent) : 0;
+    const size_t chunks = std::min(static_cast<size_t>(std::max(options.threads, 1u)),
+                                   std::max<size_t>(count / std::max<size_t>(options.minimumChunk, 1), 1));
+    Value::FormatOptions serial(options);
+
+    serial.threads = 1;
+
+    const auto run = [&](Output& out, size_t start, size_t end) {
+        for (size_t index = start; index < end; ++index) {
+            out.indent(indents, serial.indentCharacter);
+            item(out, index, serial);
+
+            if (index + 1 < count) {
+                out.append(',');
+            }
+
+            if (lines) {
+                out.append('\n');
+            }
+        }
+    };
+
+    output.append(open);
+
+    if (lines) {
+        output.append('\n');
+    }
+
+    if (chunks > 1) {
+        std::vector<std::future<std::string>> parts;
+
+        for (size_t chunk = 1; chunk < chunks; ++chunk) {
+            parts.push_back(std::async(std::launch::async, [&run, count, chunks, chunk]() {
+                std::string text;
+                Output out(text);
+
+                run(out, chunk * count / chunks, (chunk + 1) * count / chunks);
+                return text;
+            }));
+        }
+
+        run(output, 0, count / chunks);
+
+        for (auto& part : parts) {
+            output.append(part.get());
+        }
+    } else {
+        run(output, 0, count);
+    }
+
+    output.indent(lastIndents, options.indentCharacter);
+    output.append(close);
+}
+
+inline bool Instance::boolean() const {
+    YaJsonThrow(std::domain_error("wrong type"));
+}
+
+inline bool Instance::equals(const Instance& other) const {
+    return getType() == other.getType();
+}
+
+inline size_t Instance::combine(size_t seed, size_t value) {
+    return seed ^ (value + static_cast<size_t>(0x9E3779B97F4A7C15ULL) + (seed << 6) + (seed >> 2));
+}
+
+inline int64_t Instance::integer() const {
+    YaJsonThrow(std::domain_error("wrong type"));
+}
+
+inline double Instance::real() const {
+    YaJsonThrow(std::domain_error("wrong type"));
+}
+
+inline bool Instance::tryInteger(int64_t& /*value*/) const {
+    return false;
+}
+
+inline bool Instance::tryReal(double& /*value*/) const {
+    return false;
+}
+
+inline bool Instance::tryBoolean(bool& /*value*/) const {
+    return false;
+}
+
+inline const std::string* Instance::stringPointer() const {
+    return nullptr;
+}
+
+inline std::string Instance::string() const {
+    YaJsonThrow(std::domain_error("wrong type"));
+}
+
+inline int Instance::count() const {
+    YaJsonThrow(std::domain_error("wrong type"));
+}
+
+inline Value::StringList Instance::keys() const {
+    YaJsonThrow(std::domain_error("wrong type"));
+}
+
+inline const Value::Members* Instance::members() const {
+    return nullptr;
+}
+
+inline const Value::Elements* Instance::elements() const {
+    return nullptr;
+}
+
+inline bool Instance::has(const Key& /*key*/) const {
+    YaJsonThrow(std::domain_error("wrong type"));
+}
+
+inline const Value* Instance::find(const Key& /*key*/) const {
+    YaJsonThrow(std::domain_error("wrong type"));
+}
+
+inline const Value* Instance::find(size_t /*index*/) const {
+    YaJsonThrow(std::domain_error("wrong type"));
+}
+
+inline Value& Instance::get(const Key& /*key*/) {
+    YaJsonThrow(std::domain_error("wrong type"));
+}
+
+inline Value& Instance::get(size_t /*index*/) {
+    YaJsonThrow(std::domain_error("wrong type"));
+}
+
+inline void Instance::clear() {
+    YaJsonThrow(std::domain_error("wrong type"));
+}
+
+inline void Instance::erase(size_t /*start*/, size_t /*end*/) {
+    YaJsonThrow(std::domain_error("wrong type"));
+}
+
+inline void Instance::erase(const Key& /*key*/) {
+    YaJsonThrow(std::domain_error("wrong type"));
+}
+
+inline void Instance::set(const Key& /*key*/, const Value& /*value*/) {
+    YaJsonThrow(std::domain_error("wrong type"));
+}
+
+inline void Instance::append(const Value& /*value*/) {
+    YaJsonThrow(std::domain_error("wrong type"));
+}
+
+inline void Instance::insert(const Value& /*value*/, size_t /*before*/) {
+    YaJsonThrow(std::domain_error("wrong type"));
+}
+
+inline void Instance::reserve(size_t /*count*/) {
+    YaJsonThrow(std::domain_error("wrong type"));
+}
+
+inline void Instance::splice(size_t /*before*/, Instance& /*other*/, size_t /*start*/, size_t /*end*/) {
+    YaJsonThrow(std::domain_error("wrong type"));
+}
+
+inline bool Instance::reusable(char /*next*/) const {
+    return false;
+}
+
+inline bool Instance::reparse(Parser& /*parser*/) {
+    YaJsonThrow(std::domain_error("wrong type"));
+}
+
+inline bool String::parse(Parser& parser, std::string* result) {
+    parser.advance(); // skip open quote
+
+    for (;;) {
+        const auto start = parser.offset();
+
+        parser.advance(_plainLength(parser.text() + start, parser.length() - start));
+
+        if (nullptr != result) {
+            result->append(parser.text() + start, parser.offset() - start);
+        }
+
+        if (!parser.more()) {
+            return parser.fail(Value::ParseError::UnexpectedEnd);
+        }
+
+        const auto character = static_cast<unsigned char>(parser.current());
+
+        if ('"' == character) {
+            break;
+        }
+
+        if ('\\' == character) {
+            if (!_parseEscaped(parser, result)) {
+                return false;
+            }
+        } else if (character < 0x20) {
+            return parser.fail(Value::ParseError::UnexpectedCharacter);
+        } else {
+            auto after = parser.offset();
+            size_t codepoint = 0;
+
+            if (!_decode(parser.text(), parser.length(), after, codepoint)
+                    || ((codepoint >= 0xD800) && (codepoint <= 0xDFFF))) {
+                return parser.fail(Value::ParseError::InvalidCodepoint);
+            }
+
+            if (nullptr != result) {
+                result->append(parser.text() + parser.offset(), after - parser.offset());
+            }
+
+            parser.advance(after - parser.offset());
+        }
+    }
+
+    parser.advance(); // skip end quote
+    return true;
+}
+
+inline String::String(const std::string& value)
+    :_value(value) {}
+
+inline Instance *String::clone() const {
+    return new String(_value);
+}
+
+inline void String::format(Output& output, const std::string& value, const Value::FormatOptions& options) {
+    format(output, value.data(), value.length(), options);
+}
+
+inline void String::format(Output& output, const char* text, size_t length,
+                           const Value::FormatOptions& options) {
+    size_t offset = 0;
+
+    if (output.counting()) {
+        output.tally(_formattedLength(text, length, options));
+        return;
+    }
+
+    output.append('"');
+
+    while (offset < length) {
+        const auto plain = _plainLength(text + offset, length - offset, options.escapeSlash);
+
+        output.append(text + offset, plain);
+        offset += plain;
+
+        if (offset >= length) {
+            break;
+        }
+
+        const char* const escaped = _shortEscape(text[offset]);
+
+        if (nullptr != escaped) {
+            output.append(escaped, 2);
+            offset += 1;
+        } else {
+            _formatCodepoint(output, text, length, offset, options.unicode);
+        }
+    }
+
+    output.append('"');
+}
+
+inline bool String::utf16Less(const std::string& left, const std::string& right) {
+    size_t leftOffset = 0;
+    size_t rightOffset = 0;
+
+    while ((leftOffset < left.length()) && (rightOffset < right.length())) {
+        size_t leftCodepoint = 0;
+        size_t rightCodepoint = 0;
+
+        if (!_decode(left.data(), left.length(), leftOffset, leftCodepoint)
+                || !_decode(right.data(), right.length(), rightOffset, rightCodepoint)) {
+            return left < right;
+        }
+
+        if (leftCodepoint != rightCodepoint) {
+            // code points above the BMP sort by their leading (high) surrogate
+            const auto leftUnit = leftCodepoint > 0xFFFF ? 0xD800 + ((leftCodepoint - 0x10000) >> 10)
+                                                         : leftCodepoint;
+            const auto rightUnit = rightCodepoint > 0xFFFF ? 0xD800 + ((rightCodepoint - 0x10000) >> 10)
+                                                           : rightCodepoint;
+
+            return leftUnit == rightUnit ? leftCodepoint < rightCodepoint : leftUnit < rightUnit;
+        }
+    }
+
+    return (left.length() - leftOffset) < (right.length() - rightOffset);
+}
+
+inline bool String::validUtf8(const char* text, size_t length) {
+    size_t offset = 0;
+
+    while (offset < length) {
+        size_t codepoint = 0;
+
+        if (!_decode(text, length, offset, codepoint) || ((codepoint >= 0xD800) && (codepoint <= 0xDFFF))) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+inline void String::format(Output& output, const Value::FormatOptions& options, int /*indentLevel*/) const {
+    format(output, _value, options);
+}
+
+inline void String::_formatCodepoint(Output& output, const char* text, size_t length, size_t &offset,
+                                     Value::FormatOptions::Unicode unicode) {
+    const auto start = offset;
+    const auto codepoint = _codepoint(text, length, offset);
+    const bool ascii = (offset - start == 1);
+    const bool ecma6 = (codepoint > 0xFFFF); // u{xxxxxx} not supported before ecma6
+
+    if (codepoint < 0x20) { // control characters without a short escape
+        _formatEscaped(output, codepoint);
+    } else if (ascii || (Value::FormatOptions::RawUtf8 == unicode)
+                || (ecma6 && (Value::FormatOptions::EscapeBmp == unicode))) {
+        output.append(text + start, offset - start);
+    } else if (ecma6) { // UTF-16 surrogate pair
+        _formatEscaped(output, 0xD800 + ((codepoint - 0x10000) >> 10));
+        _formatEscaped(output, 0xDC00 + ((codepoint - 0x10000) & 0x3FF));
+    } else {
+        _formatEscaped(output, codepoint);
+    }
+}
+
+inline const char* String::_shortEscape(char character) {
+    switch (character) {
+        case '\\':
+            return "\\\\";
+        case '"':
+            return "\\\"";
+        case '/':
+            return "\\/";
+        case '\t':
+            return "\\t";
+        case '\r':
+            return "\\r";
+        case '\n':
+            return "\\n";
+        case '\b':
+            return "\\b";
+        case '\f':
+            return "\\f";
+        default:
+            return nullptr;
+    }
+}
+
+inline size_t String::_formattedLength(const char* text, size_t length, const Value::FormatOptions& options) {
+    size_t size = 2;
+    size_t offset = 0;
+
+    while (offset < length) {
+        const auto plain = _plainLength(text + offset, length - offset, options.escapeSlash);
+
+        size += plain;
+        offset += plain;
+
+        if (offset >= length) {
+            break;
+        }
+
+        if (nullptr != _shortEscape(text[offset])) {
+            size += 2;
+            offset += 1;
+            continue;
+        }
+
+        const auto start = offset;
+        const auto codepoint = _codepoint(text, length, offset);
+        const bool ecma6 = (codepoint > 0xFFFF);
+
+        if (codepoint < 0x20) {
+            size += 6;
+        } else if ((offset - start == 1) || (Value::FormatOptions::RawUtf8 == options.unicode)
+                    || (ecma6 && (Value::FormatOptions::EscapeBmp == options.unicode))) {
+            size += offset - start;
+        } else {
+            size += ecma6 ? 12 : 6;
+        }
+    }
+
+    return size;
+}
+
+inline void String::_formatEscaped(Output& output, size_t unit) {
+    const char* const hex = "0123456789abcdef";
+    const char escaped[] = {'\\', 'u', hex[(unit >> 12) & 0xF], hex[(unit >> 8) & 0xF],
+                            hex[(unit >> 4) & 0xF], hex[unit & 0xF]};
+
+    output.append(escaped, sizeof(escaped));
+}
+
+inline bool String::equals(const Instance& other) const {
+    if (!Instance::equals(other)) {
+        return false;
+    }
+
+    // only String reports Value::String, so the tag check makes the cast safe
+    return _value == static_cast<const String&>(other)._value;
+}
+
+inline size_t String::hash() const {
+    return combine(Value::String, std::hash<std::string>()(_value));
+}
+
+inline Value::Type String::getType() const {
+    return Value::String;
+}
+
+inline bool String::reusable(char next) const {
+    return '"' == next;
+}
+
+inline bool String::reparse(Parser& parser) {
+    _value.clear(); // keeps the capacity
+    return parse(parser, &_value);
+}
+
+inline const std::string* String::stringPointer() const {
+    return &_value;
+}
+
+inline std::string String::string() const {
+    return _value;
+}
+
+inline size_t String::_codepoint(const char* text, size_t length, size_t &offset) {
+    size_t codepoint = 0;
+
+    if (!_decode(text, length, offset, codepoint)) { // offset still points at the bad sequence
+        YaJsonThrow(std::invalid_argument("invalid codepoint: "
+                                            + std::string(text + offset, std::min<size_t>(4, length - offset))));
+    }
+
+    return codepoint;
+}
+
+inline bool String::_decode(const char* text, size_t length, size_t& offset, size_t& codepoint) {
+    /*
+            1  7   U+0000   U+007F   0xxxxxxx
+            2  11  U+0080   U+07FF   110xxxxx  10xxxxxx
+            3  16  U+0800   U+FFFF   1110xxxx  10xxxxxx  10xxxxxx
+            4  21  U+10000  U+10FFFF 11110xxx  10xxxxxx  10xxxxxx  10xxxxxx
+    */
+    static const size_t minimums[] = {0, 0x80, 0x800, 0x10000};
+    const size_t lead = offset < length ? static_cast<unsigned char>(text[offset]) : 0xFFu;
+    size_t continuations = 0;
+
+    if ((0x80 & lead) == 0) {
+        codepoint = lead;
+    } else if ((0xE0 & lead) == 0xC0) {
+        codepoint = lead & 0x1Fu;
+        continuations = 1;
+    } else if ((0xF0 & lead) == 0xE0) {
+        codepoint = lead & 0x0Fu;
+        continuations = 2;
+    } else if ((0xF8 & lead) == 0xF0) {
+        codepoint = lead & 0x07u;
+        continuations = 3;
+    } else {
+        return false;
+    }
+
+    if (length - offset <= continuations) {
+        return false;
+    }
+
+    for (size_t i = 1; i <= continuations; ++i) {
+        const size_t next = static_cast<unsigned char>(text[offset + i]);
+
+        if ((next & 0xC0) != 0x80) {
+            return false;
+        }
+
+        codepoint = (codepoint << 6) | (next & 0x3Fu);
+    }
+
+    if ((codepoint < minimums[continuations]) || (codepoint > 0x10FFFF)) {
+        return false; // overlong encoding or beyond unicode
+    }
+
+    offset += continuations + 1;
+    return true;
+}
+
+inline size_t String::_plainLength(const char* text, size_t length, bool slash) {
+    // eight bytes at a time: stop at a quote, backslash, control or non-ASCII byte (or slash)
+    const uint64_t ones = 0x0101010101010101ULL;
+    const uint64_t highs = 0x8080808080808080ULL;
+    size_t count = 0;
+
+    while (count + sizeof(uint64_t) <= length) {
+        uint64_t word;
+
+        ::memcpy(&word, text + count, sizeof(word));
+
+        const uint64_t quotes = word ^ 0x2222222222222222ULL;
+        const uint64_t backslashes = word ^ 0x5C5C5C5C5C5C5C5CULL;
+        const uint64_t slashes = slash ? word ^ 0x2F2F2F2F2F2F2F2FULL : ~0ULL;
+        const uint64_t special = ((quotes - ones) & ~quotes)
+                                | ((backslashes - ones) & ~backslashes)
+                                | ((slashes - ones) & ~slashes)
+                                | ((word - 0x2020202020202020ULL) & ~word)
+                                | word;
+
+        if ((special & highs) != 0) {
+            break;
+        }
+
+        count += sizeof(uint64_t);
+    }
+
+    while (count < length) {
+        const auto character = static_cast<unsigned char>(text[count]);
+
+        if (('"' == character) || ('\\' == character) || (character < 0x20) || (character >= 0x80)
+                || (slash && ('/' == character))) {
+            break;
+        }
+
+        count += 1;
+    }
+
+    return count;
+}
+
+inline std::string String::_utf8(size_t codepoint) {
+    /*
+        1  7   U+0000   U+007F    0xxxxxxx
+        2  11  U+0080   U+07FF    110xxxxx  10xxxxxx
+        3  16  U+0800   U+FFFF    1110xxxx  10xxxxxx  10xxxxxx
+        4  21  U+10000  U+10FFFF  11110xxx  10xxxxxx  10xxxxxx  10xxxxxx
+    */
+    std::string value;
+
+    if (codepoint <= 0x7F) {
+        value.assign(1, char(codepoint));
+    } else if (codepoint <= 0x7FF) {
+        char buffer[3];
+
+        buffer[0] = static_cast<char>((6 << 5) | (codepoint >> 6));
+        buffer[1] = static_cast<char>((2 << 6) | (codepoint & 0x3F));
+        buffer[2] = 0;
+        value = buffer;
+    } else if (codepoint <= 0xFFFF) {
+        char buffer[4];
+
+        buffer[0] = static_cast<char>((14 << 4) | ( codepoint >> 12));
+        buffer[1] = static_cast<char>((2  << 6) | ((codepoint >> 6) & 0x3F));
+        buffer[2] = static_cast<char>((2  << 6) | ( codepoint & 0x3F));
+        buffer[3] = 0;
+        value = buffer;
+    } else if (codepoint <= 0x10FFFF) {
+        char buffer[5];
+
+        buffer[0] = static_cast<char>((30 << 3) | (codepoint >> 18));
+        buffer[1] = static_cast<char>((2 << 6) | ((codepoint >> 12) & 0x3F));
+        buffer[2] = static_cast<char>((2 << 6) | ((codepoint >> 6) & 0x3F));
+        buffer[3] = static_cast<char>((2 << 6) | (codepoint & 0x3F));
+        buffer[4] = 0;
+        value = buffer;
+    } else {
+        YaJsonThrow(std::invalid_argument("invalid codepoint: " 
+                                    + std::to_string(codepoint)));
+    }
+
+    return value;
+}
+
+inline int String::_hexDigit(char character) {
+    if ((character >= '0') && (character <= '9')) {
+        return character - '0';
+    }
+
+    if ((character >= 'a') && (character <= 'f')) {
+        return character - 'a' + 10;
+    }
+
+    if ((character >= 'A') && (character <= 'F')) {
+        return character - 'A' + 10;
+    }
+
+    return -1;
+}
+
+inline bool String::_hexQuad(const char* text, size_t& value) {
+    value = 0;
+
+    for (size_t i = 0; i < 4; ++i) {
+        const int digit = _hexDigit(text[i]);
+
+        if (digit < 0) {
+            return false;
+        }
+
+        value = (value << 4) | static_cast<size_t>(digit);
+    }
+
+    return true;
+}
+
+inline bool String::_parseEscaped(Parser& parser, std::string* result) {
+    parser.advance(); // skip backslash (\) escape character
+
+    if (!parser.more()) {
+        return parser.fail(Value::ParseError::UnexpectedEnd);
+    }
+
+    char escaped = '\0';
+
+    switch (parser.current()) {
+        case '/':
+            escaped = '/';
+            break;
+        case '"':
+            escaped = '"';
+            break;
+        case '\\':
+            escaped = '\\';
+            break;
+        case 'b':
+            escaped = '\b';
+            break;
+        case 'f':
+            escaped = '\f';
+            break;
+        case 'r':
+            escaped = '\r';
+            break;
+        case 'n':
+            escaped = '\n';
+            break;
+        case 't':
+            escaped = '\t';
+            break;
+        case 'u':
+            if (!_parseEscapedUnicode(parser, result)) {
+                return false;
+            }
+            break;
+        default:
+            return parser.fail(Value::ParseError::InvalidEscape);
+    }
+
+    if (('\0' != escaped) && (nullptr != result)) {
+        *result += escaped;
+    }
+
+    parser.advance();
+    return true;
+}
+
+inline bool String::_parseEscapedUnicode(Parser& parser, std::string* result) {
+    const auto text = parser.text();
+    const auto length = parser.length();
+    const auto offset = parser.offset();
+    const bool braces = (offset + 1 < length) && ('{' == text[offset + 1]);
+    auto position = offset + (braces ? 2 : 1);
+    size_t codepoint = 0;
+    size_t digits = 0;
+
+    if (braces && parser.strict()) {
+        return parser.fail(Value::ParseError::InvalidEscape, offset + 1);
+    }
+
+    while ((position < length) && (braces ? ('}' != text[position]) : (digits < 4))) {
+        const int digit = _hexDigit(text[position]);
+
+        if (digit < 0) {
+            return parser.fail(Value::ParseError::InvalidEscape, position);
+        }
+
+        codepoint = (codepoint << 4) | static_cast<size_t>(digit);
+        digits += 1;
+        position += 1;
+
+        if (codepoint > 0x10FFFF) {
+            return parser.fail(Value::ParseError::InvalidCodepoint, offset);
+        }
+    }
+
+    if (position >= length) {
+        return parser.fail(Value::ParseError::UnexpectedEnd, position);
+    }
+
+    if (0 == digits) {
+        return parser.fail(Value::ParseError::InvalidEscape, position);
+    }
+
+    const bool high = !braces && (codepoint >= 0xD800) && (codepoint <= 0xDBFF);
+
+    if (high && (position + 6 <= length) && ('\\' == text[position]) && ('u' == text[position + 1])) {
+        size_t low = 0;
+
+        if (_hexQuad(text + position + 2, low) && (low >= 0xDC00) && (low <= 0xDFFF)) { // UTF-16 surrogate pair
+            codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+            position += 6;
+        }
+    }
+
+    parser.advance(position - offset - (braces ? 0 : 1)); // leave offset on the last character
+
+    if (nullptr != result) {
+        *result += _utf8(codepoint);
+    }
+
+    return true;
+}
+
+inline Integer::Integer(const int64_t value)
+    :_value(value) {}
+
+inline Instance *Integer::clone() const {
+    return new Integer(_value);
+}
+
+inline void Integer::format(Output& output, int64_t value) {
+    if (output.counting()) {
+        const auto magnitude = value < 0 ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+
+        output.tally((value < 0 ? 1 : 0) + Integer::digits(magnitude));
+        return;
+    }
+
+    char digits[24];
+    const int size = ::snprintf(digits, sizeof(digits), "%" PRId64, value);
+
+    output.append(digits, static_cast<size_t>(size));
+}
+
+inline void Integer::format(Output& output, uint64_t value) {
+    if (output.counting()) {
+        output.tally(Integer::digits(value));
+        return;
+    }
+
+    char digits[24];
+    const int size = ::snprintf(digits, sizeof(digits), "%" PRIu64, value);
+
+    output.append(digits, static_cast<size_t>(size));
+}
+
+inline size_t Integer::digits(uint64_t value) {
+    size_t count = 1;
+
+    for (; value >= 10; value /= 10) {
+        count += 1;
+    }
+
+    return count;
+}
+
+inline void Integer::format(Output& output, int64_t value, const Value::FormatOptions& options) {
+    const int64_t exact = int64_t(1) << 53;
+
+    // as an ECMAScript number, an integer beyond 2^53 is rounded to the nearest double first
+    if ((Value::FormatOptions::EcmaScript == options.numberFormat) && ((value > exact) || (value < -exact))) {
+        Real::formatShortest(output, static_cast<double>(value));
+    } else {
+        format(output, value);
+    }
+}
+
+inline void Integer::format(Output& output, uint64_t value, const Value::FormatOptions& options) {
+    if ((Value::FormatOptions::EcmaScript == options.numberFormat) && (value > (uint64_t(1) << 53))) {
+        Real::formatShortest(output, static_cast<double>(value));
+    } else {
+        format(output, value);
+    }
+}
+
+inline void Integer::format(Output& output, const Value::FormatOptions& options, int /*indentLevel*/) const {
+    format(output, _value, options);
+}
+
+inline bool Integer::equals(const Instance& other) const {
+    if (!Instance::equals(other)) {
+        return false;
+    }
+
+    int64_t value = 0;
+
+    return other.tryInteger(value) && (_value == value);
+}
+
+inline size_t Integer::hash() const {
+    return combine(Value::Integer, std::hash<int64_t>()(_value));
+}
+
+inline Value::Type Integer::getType() const {
+    return Value::Integer;
+}
+
+inline int64_t Integer::integer() const {
+    return _value;
+}
+
+inline bool Integer::tryInteger(int64_t& value) const {
+    value = _value;
+    return true;
+}
+
+inline Real::Real(const double value)
+    :_value(value) {}
+
+inline Instance *Real::clone() const {
+    return new Real(_value);
+}
+
+inline void Real::format(Output& output, double value) {
+    const double magnitude = std::fabs(value);
+
+    // "%f" has six decimals; below .999999 rounding cannot carry into the integer digits
+    if (output.counting() && (magnitude < 1e15) && (magnitude - std::floor(magnitude) < 0.999999)) {
+        output.tally((std::signbit(value) ? 1 : 0) + Integer::digits(static_cast<uint64_t>(magnitude)) + 7);
+        return;
+    }
+
+    output.append(std::to_string(value));
+}
+
+inline void Real::format(Output& output, double value, const Value::FormatOptions& options) {
+    if (Value::FormatOptions::EcmaScript == options.numberFormat) {
+        formatShortest(output, value);
+    } else {
+        format(output, value);
+    }
+}
+
+inline void Real::formatShortest(Output& output, double value) {
+    char text[32];
+    char digits[24];
+    size_t count = 0;
+
+    if (!std::isfinite(value)) {
+        YaJsonThrow(std::domain_error("NaN and Infinity have no JSON form"));
+    }
+
+    if (!(value < 0.0) && !(value > 0.0)) { // also -0
+        output.append('0');
+        return;
+    }
+
+    if (value < 0.0) {
+        output.append('-');
+        value = -value;
+    }
+
+#if defined(__cpp_lib_to_chars)
+    *std::to_chars(text, text + sizeof(text) - 1, value, std::chars_format::scientific).ptr = '\0';
+#else
+    // a precision that reads back also does with more digits, so search for the smallest
+    int low = 1;
+    int high = 17;
+
+    while (low < high) {
+        const int middle = low + (high - low) / 2;
+
+        ::snprintf(text, sizeof(text), "%.*e", middle - 1, value);
+
+        if (equal(::strtod(text, nullptr), value)) {
+            high = middle;
+        } else {
+            low = middle + 1;
+        }
+    }
+
+    ::snprintf(text, sizeof(text), "%.*e", low - 1, value);
+#endif
+
+    const char* const exponent = ::strchr(text, 'e');
+
+    for (const char* character = text; character < exponent; ++character) {
+        if ('.' != *character) {
+            digits[count++] = *character;
+        }
+    }
+
+    while ((count > 1) && ('0' == digits[count - 1])) {
+        count -= 1;
+    }
+
+    const long point = ::strtol(exponent + 1, nullptr, 10) + 1; // value is 0.digits times 10^point
+    const long size = static_cast<long>(count);
+
+    if ((size <= point) && (point <= 21)) {
+        output.append(digits, count).append(static_cast<size_t>(point - size), '0');
+    } else if ((0 < point) && (point <= 21)) {
+        output.append(digits, static_cast<size_t>(point)).append('.');
+        output.append(digits + point, static_cast<size_t>(size - point));
+    } else if ((-6 < point) && (point <= 0)) {
+        output.append("0.", 2).append(static_cast<size_t>(-point), '0').append(digits, count);
+    } else {
+        output.append(digits[0]);
+
+        if (count > 1) {
+            output.append('.').append(digits + 1, count - 1);
+        }
+
+        output.append(point > 0 ? "e+" : "e-", 2);
+        Integer::format(output, static_cast<int64_t>(point > 0 ? point - 1 : 1 - point));
+    }
+}
+
+inline void Real::format(Output& output, const Value::FormatOptions& options, int /*indentLevel*/) const {
+    format(output, _value, options);
+}
+
+inline bool Real::equals(const Instance& other) const {
+    if (!Instance::equals(other)) {
+        return false;
+    }
+    
+    double value = 0.0;
+
+    return other.tryReal(value) && equal(_value, value);
+}
+
+inline size_t Real::hash() const {
+    return hash(_value);
+}
+
+inline bool Real::equal(double a, double b) {
+    if (std::isnan(a) || std::isnan(b)) {
+        return std::isnan(a) && std::isnan(b);
+    }
+
+    return !(a < b) && !(b < a);
+}
+
+inline size_t Real::hash(double value) {
+    // values that compare equal must hash equal: fold -0.0 into 0.0 and every NaN into one
+    const double normalized = std::isnan(value) ? std::numeric_limits<double>::quiet_NaN()
+                                                : value + 0.0;
+
+    return combine(Value::Real, std::hash<double>()(normalized));
+}
+
+inline Value::Type Real::getType() const {
+    return Value::Real;
+}
+
+inline double Real::real() const {
+    return _value;
+}
+
+inline bool Real::tryReal(double& value) const {
+    value = _value;
+    return true;
+}
+
+inline Number::Number(const char* text, size_t size, bool real)
+    :_text(text, size), _real(real) {}
+
+inline Instance *Number::clone() const {
+    return new Number(_text.data(), _text.size(), _real);
+}
+
+inline void Number::format(Output& output, const Value::FormatOptions& options, int /*indentLevel*/) const {
+    if (Value::FormatOptions::EcmaScript == options.numberFormat) {
+        Real::formatShortest(output, ::strtod(_text.c_str(), nullptr));
+    } else {
+        output.append(_text);
+    }
+}
+
+inline bool Number::equals(const Instance& other) const {
+    if (!Instance::equals(other)) {
+        return false;
+    }
+
+    int64_t integerValue = 0;
+    int64_t otherInteger = 0;
+    double realValue = 0.0;
+    double otherReal = 0.0;
+
+    if (_real && tryReal(realValue) && other.tryReal(otherReal)) {
+        return Real::equal(realValue, otherReal);
+    }
+
+    if (!_real && tryInteger(integerValue) && other.tryInteger(otherInteger)) {
+        return integerValue == otherInteger;
+    }
+
+    // beyond the range of int64_t or double, compare the text
+    std::string otherText;
+    Output output(otherText);
+
+    other.format(output, Value::FormatOptions(), 0);
+    return _text == otherText;
+}
+
+inline size_t Number::hash() const {
+    int64_t integerValue = 0;
+    double realValue = 0.0;
+
+    if (_real && tryReal(realValue)) {
+        return Real::hash(realValue);
+    }
+
+    if (!_real && tryInteger(integerValue)) {
+        return combine(Value::Integer, std::hash<int64_t>()(integerValue));
+    }
+
+    return combine(getType(), std::hash<std::string>()(_text));
+}
+
+inline Value::Type Number::getType() const {
+    return _real ? Value::Real : Value::Integer;
+}
+
+inline bool Number::reusable(char next) const {
+    return ('-' == next) || ((next >= '0') && (next <= '9'));
+}
+
+inline bool Number::reparse(Parser& parser) {
+    const size_t start = parser.offset();
+
+    if (!parser.number(_real)) {
+        return false;
+    }
+
+    _text.assign(parser.text() + start, parser.offset() - start);
+    return true;
+}
+
+inline int64_t Number::integer() const {
+    int64_t value = 0;
+
+    if (_real) {
+        return Instance::integer();
+    }
+
+    if (!tryInteger(value)) {
+        YaJsonThrow(std::invalid_argument("Illegal Number: " + _text));
+    }
+
+    return value;
+}
+
+inline double Number::real() const {
+    double value = 0.0;
+
+    if (!_real) {
+        return Instance::real();
+    }
+
+    if (!tryReal(value)) {
+        YaJsonThrow(std::invalid_argument("Illegal Number: " + _text));
+    }
+
+    return value;
+}
+
+inline bool Number::tryInteger(int64_t& value) const {
+    char* end = nullptr;
+
+    if (_real) {
+        return false;
+    }
+
+    errno = 0;
+    value = static_cast<int64_t>(std::strtoll(_text.c_str(), &end, 10));
+    return 0 == errno;
+}
+
+inline bool Number::tryReal(double& value) const {
+    char* end = nullptr;
+
+    if (!_real) {
+        return false;
+    }
+
+    errno = 0;
+    value = std::strtod(_text.c_str(), &end);
+    return 0 == errno;
+}
+
+inline Boolean::Boolean(const bool value)
+    :_value(value) {}
+
+inline Instance *Boolean::clone() const {
+    return new Boolean(_value);
+}
+
+inline void Boolean::format(Output& output, const Value::FormatOptions& /*options*/, int /*indentLevel*/) const {
+    if (_value) {
+        output.append("true", 4);
+    } else {
+        output.append("false", 5);
+    }
+}
+
+inline bool Boolean::equals(const Instance& other) const {
+    if (!Instance::equals(other)) {
+        return false;
+    }
+
+    return _value == static_cast<const Boolean&>(other)._value;
+}
+
+inline size_t Boolean::hash() const {
+    return combine(Value::Boolean, _value ? 1 : 0);
+}
+
+inline Value::Type Boolean::getType() const {
+    return Value::Boolean;
+}
+
+inline bool Boolean::reusable(char next) const {
+    return ('t' == next) || ('f' == next);
+}
+
+inline bool Boolean::reparse(Parser& parser) {
+    _value = ('t' == parser.current());
+    return _value ? parser.literal("true", 4) : parser.literal("false", 5);
+}
+
+inline bool Boolean::boolean() const {
+    return _value;
+}
+
+inline bool Boolean::tryBoolean(bool& value) const {
+    value = _value;
+    return true;
+}
+
+inline Array* Array::parse(Parser& parser) {
+    auto result = std::unique_ptr<Array>(new Array({}));
+    auto& stack = parser._stack;
+    const auto base = stack.size();
+    bool done = false;
+
+    if (!parser.enter(']', done)) {
+        return nullptr;
+    }
+
+    while (!done) {
+        Value element;
+
+        if (!parser.parse(element) || !parser.next(']', done)) {
+            stack.resize(base);
+            return nullptr;
+        }
+
+        stack.push_back(std::move(element));
+    }
+
+    // one allocation of the final size; the shared stack keeps its capacity for the next array
+    result->_value.assign(std::make_move_iterator(stack.begin() + static_cast<std::ptrdiff_t>(base)),
+                          std::make_move_iterator(stack.end()));
+    stack.resize(base);
+    return result.release();
+}
+
+inline Array::Array(const std::vector<Value>& value)
+    :_value(value) {}
+
+inline Instance *Array::clone() const {
+    return new Array(_value);
+}
+
+inline void Array::format(Output& output, const Value::FormatOptions& options, int indentLevel) const {
+    formatItems(output, options, indentLevel, _value.size(), '[', ']',
+                [this, indentLevel](Output& out, size_t index, const Value::FormatOptions& itemOptions) {
+        _value[index].format(out, itemOptions, indentLevel + 1);
+    });
+}
+
+inline bool Array::equals(const Instance& other) const {
+    if (!Instance::equals(other)) {
+        return false;
+    }
+
+    return _value == static_cast<const Array&>(other)._value;
+}
+
+inline size_t Array::hash() const {
+    size_t result = combine(Value::Array, _value.size());
+
+    for (const auto& element : _value) {
+        result = combine(result, element.hash());
+    }
+
+    return result;
+}
+
+inline Value::Type Array::getType() const {
+    return Value::Array;
+}
+
+inline bool Array::reusable(char next) const {
+    return '[' == next;
+}
+
+inline bool Array::reparse(Parser& parser) {
+    size_t count = 0;
+    bool done = false;
+
+    if (!parser.enter(']', done)) {
+        return false;
+    }
+
+    while (!done) {
+        if (count == _value.size()) {
+            _value.push_back(Value());
+        }
+
+        if (!parser.parseInto(_value[count]) || !parser.next(']', done)) {
+            return false;
+        }
+
+        count += 1;
+    }
+
+    _value.erase(_value.begin() + static_cast<std::ptrdiff_t>(count), _value.end());
+    return true;
+}
+
+inline int Array::count() const {
+    return _value.size();
+}
+
+inline const Value::Elements* Array::elements() const {
+    return &_value;
+}
+
+inline const Value* Array::find(const Key& key) const {
+    return Instance::find(key);
+}
+
+inline const Value* Array::find(size_t index) const {
+    return index < _value.size() ? &_value[index] : nullptr;
+}
+
+inline Value& Array::get(const Key& key) {
+    return Instance::get(key);
+}
+
+inline Value& Array::get(size_t index) {
+    while (index >= _value.size()) {
+        _value.push_back(Value());
+    }
+
+    return _value[index];
+}
+
+inline void Array::clear() {
+    _value.clear();
+}
+
+inline void Array::erase(size_t start, size_t end) {
+    const auto arraySize = _value.size();
+
+    if (start >= arraySize) {
+        return;
+    }
+
+    const auto startIter = _value.begin() + static_cast<int>(start);
+    const auto endIter = end >= arraySize 
+                        ? _value.end() 
+                        : _value.begin() + static_cast<int>(end);
+
+    _value.erase(startIter, endIter);
+}
+
+inline void Array::erase(const Key& key) {
+    return Instance::erase(key);
+}
+
+inline void Array::append(const Value& value) {
+    _value.push_back(value);
+}
+
+inline void Array::insert(const Value& value, size_t before) {
+    const auto arraySize = _value.size();
+    const auto beforeIter = before >= arraySize 
+                            ? _value.end()
+                            : _value.begin() + static_cast<int>(before);
+
+    _value.insert(beforeIter, value);
+}
+
+inline void Array::reserve(size_t count) {
+    _value.reserve(count);
+}
+
+inline void Array::splice(size_t before, Instance& other, size_t start, size_t end) {
+    if (Value::Array != other.getType()) {
+        YaJsonThrow(std::domain_error("wrong type"));
+    }
+
+    auto& source = static_cast<Array&>(other)._value;
+
+    end = std::min(end, source.size());
+    start = std::min(start, end);
+    before = std::min(before, _value.size());
+
+    const auto first = source.begin() + static_cast<std::ptrdiff_t>(start);
+    const auto last = source.begin() + static_cast<std::ptrdiff_t>(end);
+    const auto target = _value.begin() + static_cast<std::ptrdiff_t>(before);
+
+    if (&source == &_value) {
+        if (before < start) {
+            std::rotate(target, first, last);
+        } else if (before > end) {
+            std::rotate(first, last, target);
+        }
+
+        return;
+    }
+
+    _value.insert(target, std::make_move_iterator(first), std::make_move_iterator(last));
+    source.erase(first, last);
+}
+
+inline Object* Object::parse(Parser& parser) {
+    auto result = std::unique_ptr<Object>(new Object({}));
+    std::string key;
+    bool done = false;
+
+    if (!parser.enter('}', done)) {
+        return nullptr;
+    }
+
+    while (!done) {
+        key.clear();
+
+        if (!parser.key(&key) || !parser.parse(result->_value[key]) || !parser.next('}', done)) {
+            return nullptr;
+        }
+    }
+
+    return result.release();
+}
+
+inline Object::Object(const Map& value)
+    :_value(value) {}
+
+inline Instance *Object::clone() const {
+    return new Object(_value);
+}
+
+inline void Object::format(Output& output, const Value::FormatOptions& options, int indentLevel) const {
+    typedef Map::const_iterator Member;
+    std::vector<Member> sorted; // random access for reordered or parallel output; otherwise walked in order
+    auto next = _value.begin();
+    // UTF-16 order differs from byte order only for keys with 4-byte UTF-8 sequences
+    const bool reorder = (Value::FormatOptions::Utf16Order == options.keyOrder)
+            && std::any_of(_value.begin(), _value.end(), [](const Map::value_type& member) {
+                   return std::any_of(member.first.begin(), member.first.end(),
+                                      [](char character) { return static_cast<unsigned char>(character) >= 0xF0; });
+               });
+
+    if (reorder || ((options.threads > 1) && (_value.size() > 1))) {
+        sorted.reserve(_value.size());
+
+        for (auto i = _value.begin(); i != _value.end(); ++i) {
+            sorted.push_back(i);
+        }
+    }
+
+    if (reorder) {
+        std::sort(sorted.begin(), sorted.end(), [](const Member& left, const Member& right) {
+            return String::utf16Less(left->first, right->first);
+        });
+    }
+
+    formatItems(output, options, indentLevel, _value.size(), '{', '}',
+                [&sorted, &next, indentLevel](Output& out, size_t index, const Value::FormatOptions& itemOptions) {
+        const auto i = sorted.empty() ? next++ : sorted[index];
+
+        String::format(out, i->first, itemOptions);
+        out.append(':');
+        i->second.format(out, itemOptions, indentLevel + 1);
+    });
+}
+
+inline bool Object::equals(const Instance& other) const {
+    if (!Instance::equals(other)) {
+        return false;
+    }
+
+    return _value == static_cast<const Object&>(other)._value;
+}
+
+inline size_t Object::hash() const {
+    size_t result = combine(Value::Object, _value.size());
+
+    for (const auto& member : _value) {
+        result = combine(combine(result, std::hash<std::string>()(member.first)), member.second.hash());
+    }
+
+    return result;
+}
+
+inline Value::Type Object::getType() const {
+    return Value::Object;
+}
+
+inline bool Object::reusable(char next) const {
+    return '{' == next;
+}
+
+inline bool Object::reparse(Parser& parser) {
+    // kept per thread so steady state parsing does not allocate; nested objects stack above mark
+    static thread_local std::vector<const Value*> members;
+    static thread_local std::string key; // not used across parseInto, so nested objects may share it
+    struct Truncate {
+        std::vector<const Value*>& list;
+        size_t size;
+
+        ~Truncate() {
+            list.resize(size);
+        }
+    } const truncate = {members, members.size()};
+    const auto mark = truncate.size;
+    bool done = false;
+    bool success = parser.enter('}', done);
+
+    while (success && !done) {
+        key.clear();
+        success = parser.key(&key);
+
+        if (success) {
+            auto& member = _value[key]; // reuses the node and its value when the key was already present
+
+            members.push_back(&member);
+            success = parser.parseInto(member) && parser.next('}', done);
+        }
+    }
+
+    if (success) { // drop members that were not in the text; keys may repeat, so count the distinct ones
+        const auto first = members.begin() + static_cast<std::ptrdiff_t>(mark);
+
+        std::sort(first, members.end(), std::less<const Value*>());
+
+        const auto last = std::unique(first, members.end());
+
+        if (static_cast<size_t>(last - first) < _value.size()) {
+            for (auto i = _value.begin(); i != _value.end();) {
+                if (std::binary_search(first, last, &i->second, std::less<const Value*>())) {
+                    ++i;
+                } else {
+                    i = _value.erase(i);
+                }
+            }
+        }
+    }
+
+    return success;
+}
+
+inline int Object::count() const {
+    return _value.size();
+}
+
+inline const Value::Members* Object::members() const {
+    return &_value;
+}
+
+inline Value::StringList Object::keys() const {
+    Value::StringList keys;
+    
+    keys.reserve(_value.size());
+    std::transform(_value.begin(), _value.end(), std::back_inserter(keys),
+                   [](const std::pair<std::string, Value>& pair) { return pair.first; });
+    return keys;
+}
+
+inline bool Object::has(const Key& key) const {
+    return _find(key) != _value.end();
+}
+
+inline const Value* Object::find(const Key& key) const {
+    const auto found = _find(key);
+
+    return found == _value.end() ? nullptr : &found->second;
+}
+
+inline const Value* Object::find(size_t index) const {
+    return Instance::find(index);
+}
+
+inline Value& Object::get(const Key& key) {
+    const auto found = _find(key);
+
+    return found == _value.end() ? _value.insert(std::make_pair(key.string(), Value())).first->second
+                                 : found->second;
+}
+
+inline Value& Object::get(size_t index) {
+    return Instance::get(index);
+}
+
+inline void Object::reserve(size_t /*count*/) {
+    // members are tree nodes, allocated one at a time
+}
+
+inline void Object::clear() {
+    _value.clear();
+}
+
+inline void Object::erase(const Key& key) {
+    const auto found = _find(key);
+
+    if (found != _value.end()) {
+        _value.erase(found);
+    }
+}
+
+inline void Object::erase(size_t start, size_t end) {
+    return Instance::erase(start, end);
+}
+
+inline void Object::set(const Key& key, const Value& value) {
+    get(key) = value;
+}
+
+inline Object::Map::const_iterator Object::_find(const Key& key) const {
+    return _find(_value, key);
+}
+
+inline Object::Map::iterator Object::_find(const Key& key) {
+    return _find(_value, key);
+}
+
+template<class Members>
+inline auto Object::_find(Members& members, const Key& key) -> decltype(members.begin()) {
+#if __cplusplus >= 201402L
+    return members.find(key);
+#else
+    // C++11 maps only search by key_type, so the key is copied into one buffer per thread
+    static thread_local std::string scratch;
+
+    scratch.assign(key.data(), key.size());
+    return members.find(scratch);
+#endif
+}
+
+template<class T>
+inline void Binding::parse(const std::string& jsonText, T& object, size_t* position) {
+    Value::ParseError error;
+
+    if (!tryParse(jsonText, object, error, position)) {
+        YaJsonThrow(std::invalid_argument(std::string(error.message()) + " at offset "
+                                            + std::to_string(error.offset)));
+    }
+}
+
+template<class T>
+inline bool Binding::tryParse(const std::string& jsonText, T& object, Value::ParseError& error,
+                              size_t* position) noexcept {
+    return tryParse(jsonText.data(), jsonText.size(), object, error, position);
+}
+
+template<class T>
+inline bool Binding::tryParse(const char* jsonText, size_t length, T& object,
+                              Value::ParseError& error, size_t* position) noexcept {
+    Parser parser(jsonText, length, nullptr == position ? 0 : *position);
+    bool success = false;
+
+#ifdef YAJSON_NO_EXCEPTIONS
+    success = read(parser, object);
+#else
+    try {
+        success = read(parser, object);
+    } catch (const std::bad_alloc&) {
+        parser.fail(Value::ParseError::OutOfMemory);
+    }
+#endif
+
+    success = success && ((nullptr != position) || parser.finish());
+    error = parser.error();
+
+    if (success && (nullptr != position)) {
+        *position = parser.offset();
+    }
+
+    return success;
+}
+
+template<class T>
+inline bool Binding::read(Parser& parser, T& object) {
+    return _read(parser, object);
+}
+
+template<class T>
+inline std::string Binding::format(const T& object, const Value::FormatOptions& options, int indentLevel) {
+    std::string buffer;
+    Output output(buffer);
+
+    _write(output, object, options, indentLevel);
+    return buffer;
+}
+
+template<class T>
+inline void Binding::format(Output& output, const T& object, const Value::FormatOptions& options,
+                            int indentLevel) {
+    _write(output, object, options, indentLevel);
+}
+
+inline Binding::_FieldReader::_FieldReader(Parser& parser, const std::string& key, uint64_t& seen)
+    :_parser(parser), _key(key), _seen(seen), _index(0), _matched(false), _success(true) {}
+
+template<size_t N, class T>
+inline bool Binding::_FieldReader::field(const char (&name)[N], T& member) {
+    if (_match(name)) {
+        _success = Binding::_read(_parser, member);
+    }
+
+    return _success;
+}
+
+template<size_t N, class T>
+inline bool Binding::_FieldReader::optional(const char (&name)[N], T& member) {
+    if (_match(name)) {
+        _parser.skipWhitespace();
+        _success = ('n' == _parser.current()) ? _parser.literal("null", 4)
+                                              : Binding::_read(_parser, member);
+    }
+
+    return _success;
+}
+
+inline bool Binding::_FieldReader::matched() const {
+    return _matched;
+}
+
+inline bool Binding::_FieldReader::success() const {
+    return _success;
+}
+
+template<size_t N>
+inline bool Binding::_FieldReader::_match(const char (&name)[N]) {
+    const size_t index = _index++;
+
+    // N is a compile time constant, so the length check and compare fold into a few instructions
+    if (_matched || (_key.size() != N - 1) || (::memcmp(_key.data(), name, N - 1) != 0)) {
+        return false;
+    }
+
+    if (index < MaximumFields) {
+        _seen |= (uint64_t(1) << index);
+    }
+
+    _matched = true;
+    return true;
+}
+
+inline Binding::_FieldChecker::_FieldChecker(uint64_t seen)
+    :_seen(seen), _index(0), _complete(true) {}
+
+template<size_t N, class T>
+inline bool Binding::_FieldChecker::field(const char (&)[N], T&) {
+    const size_t index = _index++;
+
+    if ((index < MaximumFields) && (0 == (_seen & (uint64_t(1) << index)))) {
+        _complete = false;
+    }
+
+    return _complete;
+}
+
+template<size_t N, class T>
+inline bool Binding::_FieldChecker::optional(const char (&)[N], T&) {
+    _index += 1;
+    return _complete;
+}
+
+inline bool Binding::_FieldChecker::complete() const {
+    return _complete;
+}
+
+inline Binding::_FieldWriter::_FieldWriter()
+    :_fields(), _count(0) {}
+
+template<size_t N, class T>
+inline bool Binding::_FieldWriter::field(const char (&name)[N], const T& member) {
+    const _Field entry = {name, N - 1, &member, &Binding::_writeMember<T>};
+
+    _fields[_count++] = entry;
+    return true;
+}
+
+template<size_t N, class T>
+inline bool Binding::_FieldWriter::optional(const char (&name)[N], const T& member) {
+    return _empty(member) || field(name, member);
+}
+
+inline void Binding::_FieldWriter::write(Output& output, const Value::FormatOptions& options, int indentLevel) {
+    const bool utf16 = Value::FormatOptions::Utf16Order == options.keyOrder;
+
+    std::sort(_fields, _fields + _count, [utf16](const _Field& left, const _Field& right) {
+        if (utf16) {
+            return String::utf16Less(std::string(left.name, left.length), std::string(right.name, right.length));
+        }
+
+        const int order = ::memcmp(left.name, right.name, std::min(left.length, right.length));
+
+        return (order < 0) || ((0 == order) && (left.length < right.length));
+    });
+
+    for (size_t index = 0; index < _count; ++index) {
+        _separate(output, options, indentLevel, 0 == index);
+        String::format(output, _fields[index].name, _fields[index].length, options);
+        output.append(':');
+        _fields[index].write(output, _fields[index].member, options, indentLevel + 1);
+    }
+}
+
+inline bool Binding::_read(Parser& parser, bool& value) {
+    parser.skipWhitespace();
+
+    switch (parser.current()) {
+        case 't':
+            value = true;
+            return parser.literal("true", 4);
+        case 'f':
+            value = false;
+            return parser.literal("false", 5);
+        default:
+            return _mismatch(parser);
+    }
+}
+
+inline bool Binding::_read(Parser& parser, std::string& value) {
+    parser.skipWhitespace();
+
+    if ('"' != parser.current()) {
+        return _mismatch(parser);
+    }
+
+    value.clear();
+    return String::parse(parser, &value);
+}
+
+inline bool Binding::_read(Parser& parser, Value& value) {
+    return parser.parse(value);
+}
+
+template<class T>
+inline bool Binding::_read(Parser& parser, std::vector<T>& value) {
+    bool done = false;
+
+    parser.skipWhitespace();
+
+    if ('[' != parser.current()) {
+        return _mismatch(parser);
+    }
+
+    value.clear();
+
+    if (!parser.enter(']', done)) {
+        return false;
+    }
+
+    while (!done) {
+        value.emplace_back();
+
+        if (!_read(parser, value.back()) || !parser.next(']', done)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template<class T>
+inline bool Binding::_read(Parser& parser, std::map<std::string, T>& value) {
+    std::string key;
+    bool done = false;
+
+    parser.skipWhitespace();
+
+    if ('{' != parser.current()) {
+        return _mismatch(parser);
+    }
+
+    value.clear();
+
+    if (!parser.enter('}', done)) {
+        return false;
+    }
+
+    while (!done) {
+        key.clear();
+
+        if (!parser.key(&key) || !_read(parser, value[key]) || !parser.next('}', done)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template<class T>
+inline typename std::enable_if<std::is_integral<T>::value, bool>::type
+Binding::_read(Parser& parser, T& value) {
+    return _readInteger(parser, value, std::is_signed<T>());
+}
+
+template<class T>
+inline typename std::enable_if<std::is_floating_point<T>::value, bool>::type
+Binding::_read(Parser& parser, T& value) {
+    std::string digits;
+    const size_t start = parser.offset();
+
+    if (!_number(parser, true, digits)) {
+        return false;
+    }
+
+    errno = 0;
+    const double result = ::strtod(digits.c_str(), nullptr);
+
+    if ((ERANGE == errno) && ((result > 1.0) || (result < -1.0))) {
+        return parser.fail(Value::ParseError::InvalidNumber, start);
+    }
+
+    value = static_cast<T>(result);
+    return true;
+}
+
+template<class T>
+inline typename std::enable_if<std::is_class<T>::value, bool>::type
+Binding::_read(Parser& parser, T& object) {
+    std::string key;
+    uint64_t seen = 0;
+    bool done = false;
+
+    parser.skipWhitespace();
+
+    if ('{' != parser.current()) {
+        return _mismatch(parser);
+    }
+
+    if (!parser.enter('}', done)) {
+        return false;
+    }
+
+    while (!done) {
+        key.clear();
+
+        if (!parser.key(&key)) {
+            return false;
+        }
+
+        _FieldReader reader(parser, key, seen);
+
+        Fields<T>::visit(object, reader);
+
+        if (!reader.success() || (!reader.matched() && !parser.skip())
+                || !parser.next('}', done)) {
+            return false;
+        }
+    }
+
+    _FieldChecker checker(seen);
+
+    Fields<T>::visit(object, checker);
+    return checker.complete() || parser.fail(Value::ParseError::MissingField);
+}
+
+template<class T>
+inline bool Binding::_readInteger(Parser& parser, T& value, std::true_type) {
+    std::string digits;
+    const size_t start = parser.offset();
+
+    if (!_number(parser, false, digits)) {
+        return false;
+    }
+
+    errno = 0;
+    const long long result = ::strtoll(digits.c_str(), nullptr, 10);
+
+    if ((ERANGE == errno) || (result < static_cast<long long>(std::numeric_limits<T>::min()))
+            || (result > static_cast<long long>(std::numeric_limits<T>::max()))) {
+        return parser.fail(Value::ParseError::InvalidNumber, start);
+    }
+
+    value = static_cast<T>(result);
+    return true;
+}
+
+template<class T>
+inline bool Binding::_readInteger(Parser& parser, T& value, std::false_type) {
+    std::string digits;
+    const size_t start = parser.offset();
+
+    if (!_number(parser, false, digits)) {
+        return false;
+    }
+
+    if (('-' == digits[0]) && (digits != "-0")) { // strtoull would silently negate
+        return parser.fail(Value::ParseError::InvalidNumber, start);
+    }
+
+    errno = 0;
+    const unsigned long long result = ::strtoull(digits.c_str(), nullptr, 10);
+
+    if ((ERANGE == errno) || (result > static_cast<unsigned long long>(std::numeric_limits<T>::max()))) {
+        return parser.fail(Value::ParseError::InvalidNumber, start);
+    }
+
+    value = static_cast<T>(result);
+    return true;
+}
+
+inline bool Binding::_number(Parser& parser, bool allowReal, std::string& digits) {
+    bool real = false;
+
+    parser.skipWhitespace();
+
+    const size_t start = parser.offset();
+    const char next = parser.current();
+
+    if (('-' != next) && ((next < '0') || (next > '9'))) {
+        return _mismatch(parser);
+    }
+
+    if (!parser.number(real)) {
+        return false;
+    }
+
+    if (real && !allowReal) {
+        return parser.fail(Value::ParseError::TypeMismatch, start);
+    }
+
+    // copy so strto* stops at the end of the number even when the text is not terminated
+    digits.assign(parser.text() + start, parser.offset() - start);
+    return true;
+}
+
+inline bool Binding::_mismatch(Parser& parser) {
+    return parser.fail(parser.more() ? Value::ParseError::TypeMismatch : Value::ParseError::UnexpectedEnd);
+}
+
+inline void Binding::_write(Output& output, bool value, const Value::FormatOptions& /*options*/,
+                            int /*indentLevel*/) {
+    if (value) {
+        output.append("true", 4);
+    } else {
+        output.append("false", 5);
+    }
+}
+
+inline void Binding::_write(Output& output, const std::string& value, const Value::FormatOptions& options,
+                            int /*indentLevel*/) {
+    String::format(output, value, options);
+}
+
+inline void Binding::_write(Output& output, const Value& value, const Value::FormatOptions& options,
+                            int indentLevel) {
+    value.format(output, options, indentLevel);
+}
+
+template<class T>
+inline void Binding::_write(Output& output, const std::vector<T>& value, const Value::FormatOptions& options,
+                            int indentLevel) {
+    output.append('[');
+
+    for (auto i = value.begin(); i != value.end(); ++i) {
+        _separate(output, options, indentLevel, i == value.begin());
+        _write(output, *i, options, indentLevel + 1);
+    }
+
+    _close(output, ']', options, indentLevel);
+}
+
+template<class T>
+inline void Binding::_write(Output& output, const std::map<std::string, T>& value,
+                            const Value::FormatOptions& options, int indentLevel) {
+    typedef typename std::map<std::string, T>::const_iterator Member;
+    std::vector<Member> sorted;
+
+    if (Value::FormatOptions::Utf16Order == options.keyOrder) {
+        sorted.reserve(value.size());
+
+        for (auto i = value.begin(); i != value.end(); ++i) {
+            sorted.push_back(i);
+        }
+
+        std::sort(sorted.begin(), sorted.end(), [](const Member& left, const Member& right) {
+            return String::utf16Less(left->first, right->first);
+        });
+    }
+
+    auto next = value.begin();
+
+    output.append('{');
+
+    for (size_t index = 0; index < value.size(); ++index) {
+        const auto i = sorted.empty() ? next++ : sorted[index];
+
+        _separate(output, options, indentLevel, 0 == index);
+        String::format(output, i->first, options);
+        output.append(':');
+        _write(output, i->second, options, indentLevel + 1);
+    }
+
+    _close(output, '}', options, indentLevel);
+}
+
+template<class T>
+inline typename std::enable_if<std::is_integral<T>::value>::type
+Binding::_write(Output& output, T value, const Value::FormatOptions& options, int /*indentLevel*/) {
+    if (std::is_signed<T>::value) {
+        Integer::format(output, static_cast<int64_t>(value), options);
+    } else {
+        Integer::format(output, static_cast<uint64_t>(value), options);
+    }
+}
+
+template<class T>
+inline typename std::enable_if<std::is_floating_point<T>::value>::type
+Binding::_write(Output& output, T value, const Value::FormatOptions& options, int /*indentLevel*/) {
+    Real::format(output, static_cast<double>(value), options);
+}
+
+template<class T>
+inline typename std::enable_if<std::is_class<T>::value>::type
+Binding::_write(Output& output, const T& object, const Value::FormatOptions& options, int indentLevel) {
+    _FieldWriter writer;
+
+    Fields<T>::visit(object, writer);
+    output.append('{');
+    writer.write(output, options, indentLevel);
+    _close(output, '}', options, indentLevel);
+}
+
+template<class T>
+inline void Binding::_writeMember(Output& output, const void* member, const Value::FormatOptions& options,
+                                  int indentLevel) {
+    _write(output, *static_cast<const T*>(member), options, indentLevel);
+}
+
+template<class T>
+inline bool Binding::_empty(const T& /*value*/) {
+    return false;
+}
+
+inline bool Binding::_empty(const std::string& value) {
+    return value.empty();
+}
+
+inline bool Binding::_empty(const Value& value) {
+    return value.isNull();
+}
+
+template<class T>
+inline bool Binding::_empty(const std::vector<T>& value) {
+    return value.empty();
+}
+
+template<class T>
+inline bool Binding::_empty(const std::map<std::string, T>& value) {
+    return value.empty();
+}
+
+inline void Binding::_separate(Output& output, const Value::FormatOptions& options, int indentLevel,
+                               bool first) {
+    if (!first) {
+        output.append(',');
+    }
+
+    if (options.indent >= 0) {
+        output.append('\n');
+        output.indent(static_cast<size_t>(options.indent * (indentLevel + 1)), options.indentCharacter);
+    }
+}
+
+inline void Binding::_close(Output& output, char close, const Value::FormatOptions& options,
+                            int indentLevel) {
+    if (options.indent >= 0) {
+        output.append('\n');
+        output.indent(static_cast<size_t>(options.indent * indentLevel), options.indentCharacter);
+    }
+
+    output.append(close);
+}
+
+inline std::string Binary::encode(const Value& value, Format format) {
+    std::string buffer;
+    Output output(buffer);
+
+    encode(output, value, format);
+    return buffer;
+}
+
+inline void Binary::encode(Output& output, const Value& value, Format format) {
+    if (MessagePack == format) {
+        _writeMessagePack(output, value);
+    } else {
+        _writeCbor(output, value);
+    }
+}
+
+inline Value Binary::decode(const std::string& data, Format format, size_t* position) {
+    Value value;
+    Value::ParseError error;
+
+    if (!tryDecode(data, format, value, error, position)) {
+        YaJsonThrow(std::invalid_argument(std::string(error.message()) + " at offset "
+                                            + std::to_string(error.offset)));
+    }
+
+    return value;
+}
+
+inline bool Binary::tryDecode(const std::string& data, Format format, Value& value, Value::ParseError& error,
+                              size_t* position) noexcept {
+    return tryDecode(data.data(), data.size(), format, value, error, position);
+}
+
+inline bool Binary::tryDecode(const char* data, size_t size, Format format, Value& value,
+                              Value::ParseError& error, size_t* position) noexcept {
+    Parser parser(data, size, nullptr == position ? 0 : *position);
+    Value result;
+    bool success = false;
+
+#ifdef YAJSON_NO_EXCEPTIONS
+    success = read(parser, format, result);
+#else
+    try {
+        success = read(parser, format, result);
+    } catch (const std::bad_alloc&) {
+        parser.fail(Value::ParseError::OutOfMemory);
+    }
+#endif
+
+    error = parser.error();
+
+    if (success) {
+        value._instance.swap(result._instance);
+
+        if (nullptr != position) {
+            *position = parser.offset();
+        }
+    }
+
+    return success;
+}
+
+inline bool Binary::read(Parser& parser, Format format, Value& value) {
+    return MessagePack == format ? _readMessagePack(parser, value, 0) : _readCbor(parser, value, 0);
+}
+
+inline void Binary::_writeMessagePack(Output& output, const Value& value) {
+    int64_t integer = 0;
+
+    switch (value.getType()) {
+        case Value::Null:
+        default:
+            output.append('\xC0');
+            break;
+        case Value::Boolean:
+            output.append(value.boolean() ? '\xC3' : '\xC2');
+            break;
+        case Value::Integer:
+            if (!value.tryInteger(integer)) {
+                bool negative = false;
+                const auto magnitude = _wideInteger(value, negative);
+
+                if (negative) {
+                    YaJsonThrow(std::out_of_range("Integer below the MessagePack range"));
+                }
+
+                output.append('\xCF');
+                _writeBigEndian(output, magnitude, 8);
+            } else if ((integer >= -32) && (integer < 0x80)) { // fixint
+                output.append(static_cast<char>(static_cast<uint8_t>(integer)));
+            } else if (integer > 0) {
+                const auto positive = static_cast<uint64_t>(integer);
+                const size_t bytes = positive <= 0xFF ? 1 : positive <= 0xFFFF ? 2 : positive <= 0xFFFFFFFF ? 4 : 8;
+                const unsigned leads[] = {0, 0xCC, 0xCD, 0, 0xCE, 0, 0, 0, 0xCF};
+
+                output.append(static_cast<char>(leads[bytes]));
+                _writeBigEndian(output, positive, bytes);
+            } else {
+                const size_t bytes = integer >= INT8_MIN ? 1 : integer >= INT16_MIN ? 2 : integer >= INT32_MIN ? 4 : 8;
+                const unsigned leads[] = {0, 0xD0, 0xD1, 0, 0xD2, 0, 0, 0, 0xD3};
+
+                output.append(static_cast<char>(leads[bytes]));
+                _writeBigEndian(output, static_cast<uint64_t>(integer), bytes);
+            }
+            break;
+        case Value::Real:
+            _writeReal(output, '\xCB', value.real());
+            break;
+        case Value::String: {
+            const auto& text = value.stringRef();
+
+            _writeMessagePackSize(output, text.size(), 0xA0, 32, 0xD9, 1);
+            output.append(text);
+            break;
+        }
+        case Value::Array: {
+            const auto& elements = *value.elements();
+
+            _writeMessagePackSize(output, elements.size(), 0x90, 16, 0xDC, 2);
+
+            for (const auto& element : elements) {
+                _writeMessagePack(output, element);
+            }
+            break;
+        }
+        case Value::Object: {
+            const auto& members = *value.members();
+
+            _writeMessagePackSize(output, members.size(), 0x80, 16, 0xDE, 2);
+
+            for (const auto& member : members) {
+                _writeMessagePackSize(output, member.first.size(), 0xA0, 32, 0xD9, 1);
+                output.append(member.first);
+                _writeMessagePack(output, member.second);
+            }
+            break;
+        }
+    }
+}
+
+inline void Binary::_writeMessagePackSize(Output& output, uint64_t size, unsigned fixed, uint64_t fixedLimit,
+                                          unsigned lead, size_t bytes) {
+    if (size < fixedLimit) {
+        output.append(static_cast<char>(fixed | size));
+        return;
+    }
+
+    // each following lead byte doubles the width of the size that follows it
+    while ((bytes < 8) && ((size >> (8 * bytes)) != 0)) {
+        lead += 1;
+        bytes *= 2;
+    }
+
+    if (bytes > 4) {
+        YaJsonThrow(std::length_error("Too large for MessagePack"));
+    }
+
+    output.append(static_cast<char>(lead));
+    _writeBigEndian(output, size, bytes);
+}
+
+inline void Binary::_writeCbor(Output& output, const Value& value) {
+    int64_t integer = 0;
+
+    switch (value.getType()) {
+        case Value::Null:
+        default:
+            output.append('\xF6');
+            break;
+        case Value::Boolean:
+            output.append(value.boolean() ? '\xF5' : '\xF4');
+            break;
+        case Value::Integer:
+            if (!value.tryInteger(integer)) {
+                bool negative = false;
+                const auto magnitude = _wideInteger(value, negative);
+
+                _writeCborHeader(output, negative ? 1 : 0, negative ? magnitude - 1 : magnitude);
+            } else if (integer >= 0) {
+                _writeCborHeader(output, 0, static_cast<uint64_t>(integer));
+            } else {
+                _writeCborHeader(output, 1, static_cast<uint64_t>(-(integer + 1)));
+            }
+            break;
+        case Value::Real:
+            _writeReal(output, '\xFB', value.real());
+            break;
+        case Value::String: {
+            const auto& text = value.stringRef();
+
+            _writeCborHeader(output, 3, text.size());
+            output.append(text);
+            break;
+        }
+        case Value::Array: {
+            const auto& elements = *value.elements();
+
+            _writeCborHeader(output, 4, elements.size());
+
+            for (const auto& element : elements) {
+                _writeCbor(output, element);
+            }
+            break;
+        }
+        case Value::Object: {
+            const auto& members = *value.members();
+
+            _writeCborHeader(output, 5, members.size());
+
+            for (const auto& member : members) {
+                _writeCborHeader(output, 3, member.first.size());
+                output.append(member.first);
+                _writeCbor(output, member.second);
+            }
+            break;
+        }
+    }
+}
+
+inline void Binary::_writeCborHeader(Output& output, unsigned major, uint64_t argument) {
+    const uint64_t type = major << 5;
+
+    if (argument < 24) {
+        output.append(static_cast<char>(type | argument));
+    } else {
+        const unsigned info = argument <= 0xFF ? 24 : argument <= 0xFFFF ? 25 : argument <= 0xFFFFFFFF ? 26 : 27;
+
+        output.append(static_cast<char>(type | info));
+        _writeBigEndian(output, argument, size_t(1) << (info - 24));
+    }
+}
+
+inline void Binary::_writeBigEndian(Output& output, uint64_t value, size_t bytes) {
+    char buffer[8];
+
+    for (size_t i = 0; i < bytes; ++i) {
+        buffer[bytes - i - 1] = static_cast<char>(value & 0xFF);
+        value >>= 8;
+    }
+
+    output.append(buffer, bytes);
+}
+
+inline void Binary::_writeReal(Output& output, char lead, double value) {
+    uint64_t bits = 0;
+
+    static_assert(sizeof(bits) == sizeof(value), "double is not 64 bits");
+    ::memcpy(&bits, &value, sizeof(bits));
+    output.append(lead);
+    _writeBigEndian(output, bits, 8);
+}
+
+inline uint64_t Binary::_wideInteger(const Value& value, bool& negative) {
+    const auto digits = value.format();
+    char* end = nullptr;
+
+    negative = ('-' == digits[0]);
+    errno = 0;
+
+    const auto magnitude = ::strtoull(digits.c_str() + (negative ? 1 : 0), &end, 10);
+
+    if ((ERANGE == errno) || ('\0' != *end)) {
+        YaJsonThrow(std::out_of_range("Integer beyond 64 bits: " + digits));
+    }
+
+    return magnitude;
+}
+
+inline bool Binary::_readMessagePack(Parser& parser, Value& value, size_t depth) {
+    const auto start = parser.offset();
+    unsigned lead = 0;
+    uint64_t argument = 0;
+    char container = '\0';
+
+    if (!_readByte(parser, lead)) {
+        return false;
+    }
+
+    if (lead <= 0x7F) { // positive fixint
+        value = static_cast<int64_t>(lead);
+        return true;
+    } else if (lead >= 0xE0) { // negative fixint
+        value = static_cast<int64_t>(lead) - 0x100;
+        return true;
+    } else if (lead < 0xC0) { // fixmap, fixarray and fixstr carry their size in the low bits
+        container = lead < 0x90 ? '{' : lead < 0xA0 ? '[' : '"';
+        argument = lead & ('"' == container ? 0x1Fu : 0x0Fu);
+    } else {
+        switch (lead) {
+            case 0xC0:
+                value = Value();
+                return true;
+            case 0xC2:
+            case 0xC3:
+                value = (0xC3 == lead);
+                return true;
+            case 0xCA:
+            case 0xCB: {
+                const size_t bytes = 0xCA == lead ? 4 : 8;
+
+                if (!_readBigEndian(parser, bytes, argument)) {
+                    return false;
+                }
+
+                value = _real(argument, bytes);
+                return true;
+            }
+            case 0xCC:
+            case 0xCD:
+            case 0xCE:
+            case 0xCF:
+                if (!_readBigEndian(parser, size_t(1) << (lead - 0xCC), argument)) {
+                    return false;
+                }
+
+                _unsigned(argument, value);
+                return true;
+            case 0xD0:
+            case 0xD1:
+            case 0xD2:
+            case 0xD3: {
+                const size_t bytes = size_t(1) << (lead - 0xD0);
+                const uint64_t sign = uint64_t(1) << (8 * bytes - 1);
+
+                if (!_readBigEndian(parser, bytes, argument)) {
+                    return false;
+                }
+
+                value = (argument & sign) != 0 ? -static_cast<int64_t>(~argument & (sign - 1)) - 1
+                                               : static_cast<int64_t>(argument);
+                return true;
+            }
+            case 0xD9:
+            case 0xDA:
+            case 0xDB:
+                container = '"';
+                break;
+            case 0xDC:
+            case 0xDD:
+                container = '[';
+                break;
+            case 0xDE:
+            case 0xDF:
+                container = '{';
+                break;
+            case 0xC4: // bin
+            case 0xC5:
+            case 0xC6:
+            case 0xC7: // ext
+            case 0xC8:
+            case 0xC9:
+            case 0xD4: // fixext
+            case 0xD5:
+            case 0xD6:
+            case 0xD7:
+            case 0xD8:
+                return parser.fail(Value::ParseError::TypeMismatch, start);
+            default:
+                return parser.fail(Value::ParseError::UnexpectedCharacter, start);
+        }
+
+        const size_t bytes = '"' == container ? size_t(1) << (lead - 0xD9)
+                                              : size_t(2) << (lead - ('[' == container ? 0xDC : 0xDE));
+
+        if (!_readBigEndian(parser, bytes, argument)) {
+            return false;
+        }
+    }
+
+    if ('"' == container) {
+        std::string text;
+
+        if (!_readText(parser, argument, text)) {
+            return false;
+        }
+
+        value = text;
+        return true;
+    }
+
+    if (depth >= Parser::MaximumDepth) {
+        return parser.fail(Value::ParseError::NestingTooDeep, start);
+    }
+
+    if ('[' == container) {
+        value = Value::array();
+
+        for (uint64_t index = 0; index < argument; ++index) {
+            if (!_readMessagePack(parser, value.get(static_cast<size_t>(index)), depth + 1)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    std::string key;
+
+    value = Value::object();
+
+    for (uint64_t index = 0; index < argument; ++index) {
+        if (!_readMessagePackKey(parser, key) || !_readMessagePack(parser, value.get(key), depth + 1)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+inline bool Binary::_readMessagePackKey(Parser& parser, std::string& key) {
+    const auto start = parser.offset();
+    unsigned lead = 0;
+    uint64_t size = 0;
+
+    if (!_readByte(parser, lead)) {
+        return false;
+    }
+
+    if ((lead & 0xE0) == 0xA0) {
+        size = lead & 0x1F;
+    } else if ((lead >= 0xD9) && (lead <= 0xDB)) {
+        if (!_readBigEndian(parser, size_t(1) << (lead - 0xD9), size)) {
+            return false;
+        }
+    } else {
+        return parser.fail(Value::ParseError::TypeMismatch, start);
+    }
+
+    key.clear();
+    return _readText(parser, size, key);
+}
+
+inline bool Binary::_readCbor(Parser& parser, Value& value, size_t depth) {
+    const auto start = parser.offset();
+    unsigned major = 0;
+    unsigned info = 0;
+    uint64_t argument = 0;
+
+    if (!_readCborHeader(parser, major, info, argument)) {
+        return false;
+    }
+
+    const bool indefinite = (31 == info);
+
+    if (indefinite && ((major < 2) || (major > 5))) { // also a break code outside of a container
+        return parser.fail(Value::ParseError::UnexpectedCharacter, start);
+    }
+
+    switch (major) {
+        case 0:
+            _unsigned(argument, value);
+            return true;
+        case 1:
+            _negative(argument, value);
+            return true;
+        case 2: // byte string
+            return parser.fail(Value::ParseError::TypeMismatch, start);
+        case 3: {
+            std::string text;
+
+            if (!_readCborText(parser, info, argument, text)) {
+                return false;
+            }
+
+            value = text;
+            return true;
+        }
+        case 6: // tags are dropped, keeping the value they annotate
+            if (depth >= Parser::MaximumDepth) {
+                return parser.fail(Value::ParseError::NestingTooDeep, start);
+            }
+
+            return _readCbor(parser, value, depth + 1);
+        case 7:
+            if ((20 == info) || (21 == info)) {
+                value = (21 == info);
+            } else if ((22 == info) || (23 == info)) { // null and undefined
+                value = Value();
+            } else if (info >= 25) {
+                value = _real(argument, size_t(1) << (info - 24));
+            } else { // other simple values
+                return parser.fail(Value::ParseError::TypeMismatch, start);
+            }
+
+            return true;
+        default:
+            break;
+    }
+
+    if (depth >= Parser::MaximumDepth) {
+        return parser.fail(Value::ParseError::NestingTooDeep, start);
+    }
+
+    if (4 == major) {
+        value = Value::array();
+
+        for (uint64_t index = 0; indefinite ? !_cborBreak(parser) : index < argument; ++index) {
+            if (!_readCbor(parser, value.get(static_cast<size_t>(index)), depth + 1)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    std::string key;
+
+    value = Value::object();
+
+    for (uint64_t index = 0; indefinite ? !_cborBreak(parser) : index < argument; ++index) {
+        if (!_readCborKey(parser, key) || !_readCbor(parser, value.get(key), depth + 1)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+inline bool Binary::_readCborHeader(Parser& parser, unsigned& major, unsigned& info, uint64_t& argument) {
+    unsigned lead = 0;
+
+    if (!_readByte(parser, lead)) {
+        return false;
+    }
+
+    major = lead >> 5;
+    info = lead & 0x1F;
+    argument = info;
+
+    if ((info < 24) || (31 == info)) {
+        return true;
+    }
+
+    if (info > 27) { // reserved
+        return parser.fail(Value::ParseError::UnexpectedCharacter, parser.offset() - 1);
+    }
+
+    return _readBigEndian(parser, size_t(1) << (info - 24), argument);
+}
+
+inline bool Binary::_readCborText(Parser& parser, unsigned info, uint64_t argument, std::string& text) {
+    text.clear();
+
+    if (31 != info) {
+        return _readText(parser, argument, text);
+    }
+
+    while (!_cborBreak(parser)) { // indefinite length text is a series of definite length chunks
+        const auto chunk = parser.offset();
+        unsigned major = 0;
+        unsigned chunkInfo = 0;
+        uint64_t size = 0;
+
+        if (!_readCborHeader(parser, major, chunkInfo, size)) {
+            return false;
+        }
+
+        if ((3 != major) || (31 == chunkInfo)) {
+            return parser.fail(Value::ParseError::UnexpectedCharacter, chunk);
+        }
+
+        if (!_readText(parser, size, text)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+inline bool Binary::_readCborKey(Parser& parser, std::string& key) {
+    const auto start = parser.offset();
+    unsigned major = 0;
+    unsigned info = 0;
+    uint64_t argument = 0;
+
+    if (!_readCborHeader(parser, major, info, argument)) {
+        return false;
+    }
+
+    if (3 != major) {
+        return parser.fail(Value::ParseError::TypeMismatch, start);
+    }
+
+    return _readCborText(parser, info, argument, key);
+}
+
+inline bool Binary::_readByte(Parser& parser, unsigned& byte) {
+    if (!parser.more()) {
+        return parser.fail(Value::ParseError::UnexpectedEnd);
+    }
+
+    byte = static_cast<unsigned char>(parser.current());
+    parser.advance();
+    return true;
+}
+
+inline bool Binary::_readBigEndian(Parser& parser, size_t bytes, uint64_t& value) {
+    if (parser.length() - parser.offset() < bytes) {
+        return parser.fail(Value::ParseError::UnexpectedEnd, parser.length());
+    }
+
+    const auto data = parser.text() + parser.offset();
+
+    value = 0;
+
+    for (size_t i = 0; i < bytes; ++i) {
+        value = (value << 8) | static_cast<unsigned char>(data[i]);
+    }
+
+    parser.advance(bytes);
+    return true;
+}
+
+inline bool Binary::_readText(Parser& parser, uint64_t size, std::string& text) {
+    const auto start = parser.offset();
+
+    if (parser.length() - start < size) {
+        return parser.fail(Value::ParseError::UnexpectedEnd, parser.length());
+    }
+
+    const auto length = static_cast<size_t>(size);
+
+    if (!String::validUtf8(parser.text() + start, length)) {
+        return parser.fail(Value::ParseError::InvalidCodepoint, start);
+    }
+
+    text.append(parser.text() + start, length);
+    parser.advance(length);
+    return true;
+}
+
+inline bool Binary::_cborBreak(Parser& parser) {
+    if (parser.more() && (0xFF == static_cast<unsigned char>(parser.current()))) {
+        parser.advance();
+        return true;
+    }
+
+    return false;
+}
+
+inline void Binary::_unsigned(uint64_t value, Value& result) {
+    if (value <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+        result = static_cast<int64_t>(value);
+    } else { // kept as a number beyond int64_t, as the text parser does
+        result = Value::parse(std::to_string(value));
+    }
+}
+
+inline void Binary::_negative(uint64_t argument, Value& result) {
+    if (argument <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+        result = -static_cast<int64_t>(argument) - 1;
+    } else if (std::numeric_limits<uint64_t>::max() == argument) {
+        result = Value::parse("-18446744073709551616");
+    } else {
+        result = Value::parse("-" + std::to_string(argument + 1));
+    }
+}
+
+inline double Binary::_real(uint64_t bits, size_t bytes) {
+    if (8 == bytes) {
+        double value = 0.0;
+
+        ::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    if (4 == bytes) {
+        const auto narrow = static_cast<uint32_t>(bits);
+        float value = 0.0f;
+
+        ::memcpy(&value, &narrow, sizeof(value));
+        return static_cast<double>(value);
+    }
+
+    // IEEE 754 half precision, as decoded in RFC 8949 appendix D
+    const auto exponent = static_cast<int>((bits >> 10) & 0x1F);
+    const auto mantissa = bits & 0x3FF;
+    double magnitude = 0.0;
+
+    if (0 == exponent) {
+        magnitude = std::ldexp(static_cast<double>(mantissa), -24);
+    } else if (31 != exponent) {
+        magnitude = std::ldexp(static_cast<double>(mantissa + 0x400), exponent - 25);
+    } else {
+        magnitude = 0 == mantissa ? std::numeric_limits<double>::infinity()
+                                  : std::numeric_limits<double>::quiet_NaN();
+    }
+
+    return (bits & 0x8000) != 0 ? -magnitude : magnitude;
+}
+
+inline std::string Snapshot::write(const Value& value) {
+    std::string buffer("YJSN", 4);
+    _Strings strings;
+
+    buffer.resize(_RootSlot + _SlotSize);
+    _put(buffer, 4, Version, 4);
+    _slot(buffer, _RootSlot, value, strings);
+
+    if (buffer.size() > std::numeric_limits<uint32_t>::max()) {
+        YaJsonThrow(std::length_error("Snapshot larger than 4 GiB"));
+    }
+
+    return buffer;
+}
+
+inline void Snapshot::write(Sink& sink, const Value& value) {
+    const auto buffer = write(value);
+
+    sink.write(buffer.data(), buffer.size());
+}
+
+inline void Snapshot::_slot(std::string& buffer, size_t position, const Value& value, _Strings& strings) {
+    _Tag tag = _NullTag;
+    uint64_t payload = 0;
+    int64_t integer = 0;
+
+    switch (value.getType()) {
+        case Value::Boolean:
+            tag = value.boolean() ? _TrueTag : _FalseTag;
+            break;
+        case Value::Integer:
+            if (value.tryInteger(integer)) {
+                tag = _IntegerTag;
+                payload = static_cast<uint64_t>(integer);
+            } else { // beyond int64_t, keep the digits
+                tag = _NumberTag;
+                payload = _text(buffer, value.format(), strings);
+            }
+            break;
+        case Value::Real: {
+            const double real = value.real();
+
+            tag = _RealTag;
+            ::memcpy(&payload, &real, sizeof(payload));
+            break;
+        }
+        case Value::String:
+            tag = _StringTag;
+            payload = _text(buffer, value.stringRef(), strings);
+            break;
+        case Value::Array: {
+            const auto& elements = *value.elements();
+            const auto record = buffer.size();
+
+            buffer.resize(record + elements.size() * _SlotSize);
+
+            for (size_t index = 0; index < elements.size(); ++index) {
+                _slot(buffer, record + index * _SlotSize, elements[index], strings);
+            }
+
+            tag = _ArrayTag;
+            payload = _reference(record, elements.size());
+            break;
+        }
+        case Value::Object: {
+            const auto& members = *value.members();
+            const auto record = buffer.size();
+            auto entry = record;
+
+            buffer.resize(record + members.size() * _EntrySize);
+
+            for (const auto& member : members) { // already in key byte order
+                _put(buffer, entry, _text(buffer, member.first, strings), 8);
+                _slot(buffer, entry + 8, member.second, strings);
+                entry += _EntrySize;
+            }
+
+            tag = _ObjectTag;
+            payload = _reference(record, members.size());
+            break;
+        }
+        case Value::Null:
+        default:
+            break;
+    }
+
+    buffer[position] = static_cast<char>(tag);
+    _put(buffer, position + 1, payload, 8);
+}
+
+inline uint64_t Snapshot::_text(std::string& buffer, const std::string& text, _Strings& strings) {
+    const auto found = strings.find(text);
+
+    if (found != strings.end()) { // repeated keys and strings are stored once
+        return found->second;
+    }
+
+    const auto reference = _reference(buffer.size(), text.size());
+
+    buffer.append(text);
+    buffer.append(1, '\0');
+    strings.insert(std::make_pair(text, reference));
+    return reference;
+}
+
+inline void Snapshot::_put(std::string& buffer, size_t position, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+        buffer[position + i] = static_cast<char>(value & 0xFF);
+        value >>= 8;
+    }
+}
+
+inline uint64_t Snapshot::_reference(size_t offset, size_t size) {
+    return (static_cast<uint64_t>(size) << 32) | static_cast<uint32_t>(offset);
+}
+
+inline SnapshotView::SnapshotView()
+    :_data(nullptr), _size(0), _slot(0) {}
+
+inline SnapshotView::SnapshotView(const char* data, size_t size)
+    :_data(data), _size(size), _slot(Snapshot::_RootSlot) {
+    if ((size < Snapshot::_RootSlot + Snapshot::_SlotSize) || (0 != ::memcmp(data, "YJSN", 4))) {
+        YaJsonThrow(std::invalid_argument("not a yajson snapshot"));
+    }
+
+    if (_read(data + 4, 4) != Snapshot::Version) {
+        YaJsonThrow(std::invalid_argument("unsupported snapshot version"));
+    }
+}
+
+inline SnapshotView::SnapshotView(const char* data, size_t size, size_t slot)
+    :_data(data), _size(size), _slot(slot) {}
+
+inline Value::Type SnapshotView::getType() const {
+    static const Value::Type types[] = {Value::Null, Value::Boolean, Value::Boolean, Value::Integer, Value::Real,
+                                        Value::String, Value::Integer, Value::Array, Value::Object};
+    const auto tag = _tag();
+
+    if (tag > Snapshot::_ObjectTag) {
+        YaJsonThrow(std::invalid_argument("corrupt snapshot"));
+    }
+
+    return types[tag];
+}
+
+inline bool SnapshotView::is(Value::Type valueType) const {
+    return getType() == valueType;
+}
+
+inline bool SnapshotView::isNull() const {
+    return Snapshot::_NullTag == _tag();
+}
+
+inline bool SnapshotView::boolean() const {
+    const auto tag = _tag();
+
+    if ((Snapshot::_TrueTag != tag) && (Snapshot::_FalseTag != tag) && (Snapshot::_NullTag != tag)) {
+        YaJsonThrow(std::domain_error("wrong type"));
+    }
+
+    return Snapshot::_TrueTag == tag;
+}
+
+inline int64_t SnapshotView::integer() const {
+    switch (_tag()) {
+        case Snapshot::_NullTag:
+            return 0;
+        case Snapshot::_IntegerTag:
+            return static_cast<int64_t>(_payload());
+        case Snapshot::_NumberTag:
+            return Value::parse(_text(_slot + 1).string()).integer();
+        default:
+            YaJsonThrow(std::domain_error("wrong type"));
+    }
+}
+
+inline double SnapshotView::real() const {
+    double value = 0.0;
+    const auto tag = _tag();
+
+    if ((Snapshot::_RealTag != tag) && (Snapshot::_NullTag != tag)) {
+        YaJsonThrow(std::domain_error("wrong type"));
+    }
+
+    if (Snapshot::_RealTag == tag) {
+        const auto bits = _payload();
+
+        ::memcpy(&value, &bits, sizeof(value));
+    }
+
+    return value;
+}
+
+inline std::string SnapshotView::string() const {
+    return _string().string();
+}
+
+inline const char* SnapshotView::stringData() const {
+    return _string().data();
+}
+
+inline size_t SnapshotView::stringSize() const {
+    return _string().size();
+}
+
+#if __cplusplus >= 201703L
+inline std::string_view SnapshotView::stringView() const {
+    const auto text = _string();
+
+    return std::string_view(text.data(), text.size());
+}
+#endif
+
+inline int SnapshotView::count() const {
+    const auto tag = _tag();
+
+    if ((Snapshot::_ArrayTag != tag) && (Snapshot::_ObjectTag != tag) && (Snapshot::_NullTag != tag)) {
+        YaJsonThrow(std::domain_error("wrong type"));
+    }
+
+    return static_cast<int>(_payload() >> 32);
+}
+
+inline Value::StringList SnapshotView::keys() const {
+    Value::StringList names;
+
+    if (isNull()) {
+        return names;
+    }
+
+    const auto record = _record(Snapshot::_ObjectTag, Snapshot::_EntrySize);
+    const auto size = static_cast<size_t>(_payload() >> 32);
+
+    names.reserve(size);
+
+    for (size_t index = 0; index < size; ++index) {
+        names.push_back(_text(record + index * Snapshot::_EntrySize).string());
+    }
+
+    return names;
+}
+
+inline Key SnapshotView::key(size_t index) const {
+    const auto record = _record(Snapshot::_ObjectTag, Snapshot::_EntrySize);
+
+    if (index >= static_cast<size_t>(_payload() >> 32)) {
+        YaJsonThrow(std::out_of_range("index out of range: " + std::to_string(index)));
+    }
+
+    return _text(record + index * Snapshot::_EntrySize);
+}
+
+inline SnapshotView SnapshotView::member(size_t index) const {
+    const auto record = _record(Snapshot::_ObjectTag, Snapshot::_EntrySize);
+
+    if (index >= static_cast<size_t>(_payload() >> 32)) {
+        YaJsonThrow(std::out_of_range("index out of range: " + std::to_string(index)));
+    }
+
+    return SnapshotView(_data, _size, record + index * Snapshot::_EntrySize + 8);
+}
+
+inline bool SnapshotView::has(const Key& key) const {
+    size_t index = 0;
+
+    return isNull() ? false : _find(key, index);
+}
+
+inline SnapshotView SnapshotView::at(const Key& key) const {
+    size_t index = 0;
+
+    if (isNull()) {
+        YaJsonThrow(std::domain_error("null"));
+    }
+
+    if (!_find(key, index)) {
+        YaJsonThrow(std::out_of_range("missing key: " + key.string()));
+    }
+
+    return member(index);
+}
+
+inline SnapshotView SnapshotView::at(size_t index) const {
+    if (isNull()) {
+        YaJsonThrow(std::domain_error("null"));
+    }
+
+    const auto record = _record(Snapshot::_ArrayTag, Snapshot::_SlotSize);
+
+    if (index >= static_cast<size_t>(_payload() >> 32)) {
+        YaJsonThrow(std::out_of_range("index out of range: " + std::to_string(index)));
+    }
+
+    return SnapshotView(_data, _size, record + index * Snapshot::_SlotSize);
+}
+
+inline SnapshotView SnapshotView::operator[](const Key& key) const {
+    size_t index = 0;
+
+    if (isNull()) {
+        YaJsonThrow(std::domain_error("null"));
+    }
+
+    return _find(key, index) ? member(index) : SnapshotView();
+}
+
+inline SnapshotView SnapshotView::operator[](size_t index) const {
+    if (isNull()) {
+        YaJsonThrow(std::domain_error("null"));
+    }
+
+    const auto record = _record(Snapshot::_ArrayTag, Snapshot::_SlotSize);
+
+    return index < static_cast<size_t>(_payload() >> 32)
+            ? SnapshotView(_data, _size, record + index * Snapshot::_SlotSize) : SnapshotView();
+}
+
+inline Value SnapshotView::value() const {
+    Value result;
+
+    _fill(result, 0);
+    return result;
+}
+
+inline unsigned SnapshotView::_tag() const {
+    return 0 == _slot ? static_cast<unsigned>(Snapshot::_NullTag) : static_cast<unsigned char>(_data[_slot]);
+}
+
+inline uint64_t SnapshotView::_payload() const {
+    return 0 == _slot ? 0 : _read(_data + _slot + 1, 8);
+}
+
+inline size_t SnapshotView::_record(unsigned tag, size_t entrySize) const {
+    if (_tag() != tag) {
+        YaJsonThrow(std::domain_error(isNull() ? "null" : "wrong type"));
+    }
+
+    const auto payload = _payload();
+    const auto offset = static_cast<size_t>(payload & 0xFFFFFFFF);
+    const auto size = static_cast<size_t>(payload >> 32);
+
+    // records always follow the slot that refers to them, so a damaged file cannot form a cycle
+    if ((offset <= _slot) || (offset > _size) || (size > (_size - offset) / entrySize)) {
+        YaJsonThrow(std::invalid_argument("corrupt snapshot"));
+    }
+
+    return offset;
+}
+
+inline Key SnapshotView::_text(size_t position) const {
+    const auto payload = _read(_data + position, 8);
+    const auto offset = static_cast<size_t>(payload & 0xFFFFFFFF);
+    const auto size = static_cast<size_t>(payload >> 32);
+
+    if ((offset > _size) || (size >= _size - offset)) { // room for the terminating nul
+        YaJsonThrow(std::invalid_argument("corrupt snapshot"));
+    }
+
+    return Key(_data + offset, size);
+}
+
+inline bool SnapshotView::_find(const Key& key, size_t& index) const {
+    const auto record = _record(Snapshot::_ObjectTag, Snapshot::_EntrySize);
+    size_t low = 0;
+    size_t high = static_cast<size_t>(_payload() >> 32);
+
+    while (low < high) {
+        const auto middle = low + (high - low) / 2;
+        const auto name = _text(record + middle * Snapshot::_EntrySize);
+        const auto common = std::min(name.size(), key.size());
+        int order = 0 == common ? 0 : ::memcmp(name.data(), key.data(), common);
+
+        if (0 == order) {
+            order = name.size() < key.size() ? -1 : (name.size() > key.size() ? 1 : 0);
+        }
+
+        if (0 == order) {
+            index = middle;
+            return true;
+        }
+
+        if (order < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return false;
+}
+
+inline Key SnapshotView::_string() const {
+    const auto tag = _tag();
+
+    if ((Snapshot::_StringTag != tag) && (Snapshot::_NullTag != tag)) {
+        YaJsonThrow(std::domain_error("wrong type"));
+    }
+
+    return Snapshot::_StringTag == tag ? _text(_slot + 1) : Key("", 0);
+}
+
+inline void SnapshotView::_fill(Value& target, size_t depth) const {
+    if (depth > Parser::MaximumDepth) {
+        YaJsonThrow(std::invalid_argument("snapshot nested too deeply"));
+    }
+
+    switch (_tag()) {
+        case Snapshot::_NullTag:
+            target = Value();
+            break;
+        case Snapshot::_FalseTag:
+        case Snapshot::_TrueTag:
+            target = boolean();
+            break;
+        case Snapshot::_IntegerTag:
+            target = integer();
+            break;
+        case Snapshot::_RealTag:
+            target = real();
+            break;
+        case Snapshot::_StringTag:
+            target = string();
+            break;
+        case Snapshot::_NumberTag:
+            target = Value::parse(_text(_slot + 1).string());
+            break;
+        case Snapshot::_ArrayTag: {
+            const auto size = static_cast<size_t>(count());
+
+            target = Value::array();
+
+            for (size_t index = 0; index < size; ++index) {
+                at(index)._fill(target.get(index), depth + 1);
+            }
+            break;
+        }
+        case Snapshot::_ObjectTag: {
+            const auto size = static_cast<size_t>(count());
+
+            target = Value::object();
+
+            for (size_t index = 0; index < size; ++index) {
+                member(index)._fill(target.get(key(index)), depth + 1);
+            }
+            break;
+        }
+        default:
+            YaJsonThrow(std::invalid_argument("corrupt snapshot"));
+    }
+}
+
+inline uint64_t SnapshotView::_read(const char* data, size_t bytes) {
+    uint64_t value = 0;
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+    if (sizeof(value) == bytes) { // the common case: one unaligned load
+        ::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+#endif
+
+    for (size_t i = bytes; i > 0; --i) {
+        value = (value << 8) | static_cast<unsigned char>(data[i - 1]);
+    }
+
+    return value;
+}
+
+inline bool Pointer::split(const std::string& pointer, Value::StringList& tokens) {
+    std::string token;
+
+    tokens.clear();
+
+    if (pointer.empty()) { // the whole document
+        return true;
+    }
+
+    if ('/' != pointer[0]) {
+        return false;
+    }
+
+    for (size_t i = 1; i <= pointer.size(); ++i) {
+        if ((pointer.size() == i) || ('/' == pointer[i])) {
+            tokens.push_back(token);
+            token.clear();
+        } else if ('~' == pointer[i]) {
+            const char escaped = i + 1 < pointer.size() ? pointer[i + 1] : '\0';
+
+            if (('0' != escaped) && ('1' != escaped)) {
+                return false;
+            }
+
+            token.append(1, '0' == escaped ? '~' : '/');
+            i += 1;
+        } else {
+            token.append(1, pointer[i]);
+        }
+    }
+
+    return true;
+}
+
+inline std::string& Pointer::append(std::string& pointer, const Key& token) {
+    pointer.append(1, '/');
+
+    for (size_t i = 0; i < token.size(); ++i) {
+        if ('~' == token.data()[i]) {
+            pointer.append("~0");
+        } else if ('/' == token.data()[i]) {
+            pointer.append("~1");
+        } else {
+            pointer.append(1, token.data()[i]);
+        }
+    }
+
+    return pointer;
+}
+
+inline bool Pointer::index(const std::string& token, size_t& index) {
+    if (token.empty() || ((token.size() > 1) && ('0' == token[0]))) {
+        return false;
+    }
+
+    index = 0;
+
+    for (const auto character : token) {
+        if ((character < '0') || (character > '9')) {
+            return false;
+        }
+
+        const auto digit = static_cast<size_t>(character - '0');
+
+        if (index > (std::numeric_limits<size_t>::max() - digit) / 10) {
+            return false;
+        }
+
+        index = index * 10 + digit;
+    }
+
+    return true;
+}
+
+template<class V>
+inline V* Pointer::resolve(V& root, const Value::StringList& tokens, size_t count) {
+    V* current = &root;
+
+    for (size_t i = 0; (i < count) && (nullptr != current); ++i) {
+        size_t position = 0;
+
+        if (current->is(Value::Object)) {
+            current = current->find(Key(tokens[i]));
+        } else if (current->is(Value::Array) && index(tokens[i], position)) {
+            current = current->find(position);
+        } else {
+            current = nullptr;
+        }
+    }
+
+    return current;
+}
+
+inline Projection::_Node::_Node()
+    :children(), whole(false) {}
+
+inline Projection::Projection()
+    :_nodes(1) {}
+
+inline Projection::Projection(std::initializer_list<std::string> pointers)
+    :_nodes(1) {
+    for (const auto& pointer : pointers) {
+        add(pointer);
+    }
+}
+
+inline Projection::Projection(const Value::StringList& pointers)
+    :_nodes(1) {
+    for (const auto& pointer : pointers) {
+        add(pointer);
+    }
+}
+
+inline Projection& Projection::add(const std::string& pointer) {
+    Value::StringList tokens;
+    size_t node = 0;
+
+    if (!Pointer::split(pointer, tokens)) {
+        YaJsonThrow(std::invalid_argument("invalid JSON pointer: " + pointer));
+    }
+
+    for (const auto& token : tokens) {
+        if (_nodes[node].whole) {
+            return *this;
+        }
+
+        const auto found = _nodes[node].children.find(token);
+
+        if (_nodes[node].children.end() == found) {
+            _nodes.push_back(_Node());
+            _nodes[node].children[token] = _nodes.size() - 1;
+            node = _nodes.size() - 1;
+        } else {
+            node = found->second;
+        }
+    }
+
+    _nodes[node].whole = true;
+    return *this;
+}
+
+inline bool Projection::empty() const {
+    return !_nodes[0].whole && _nodes[0].children.empty();
+}
+
+inline void Patch::apply(Value& target, const Value& patch) {
+    const auto operations = patch.elements();
+    _Log log;
+    std::string error;
+    size_t index = 0;
+    bool success = true;
+
+    if (nullptr == operations) {
+        YaJsonThrow(std::invalid_argument("patch is not an array"));
+    }
+
+#ifdef YAJSON_NO_EXCEPTIONS
+    for (; success && (index < operations->size()); ++index) {
+        success = _operation(target, (*operations)[index], log, error);
+    }
+#else
+    try {
+        for (; success && (index < operations->size()); ++index) {
+            success = _operation(target, (*operations)[index], log, error);
+        }
+    } catch (...) {
+        _rollback(target, log);
+        throw;
+    }
+#endif
+
+    if (!success) {
+        _rollback(target, log);
+        YaJsonThrow(std::invalid_argument("patch operation " + std::to_string(index - 1) + ": " + error));
+    }
+}
+
+inline void Patch::merge(Value& target, const Value& patch) {
+    Value::StringList path;
+    _Log log;
+
+#ifdef YAJSON_NO_EXCEPTIONS
+    _merge(target, patch, path, log);
+#else
+    try {
+        _merge(target, patch, path, log);
+    } catch (...) {
+        _rollback(target, log);
+        throw;
+    }
+#endif
+}
+
+inline void Patch::merge(Value& target, Value&& overlay, const Value::MergePolicy& policy) {
+    std::string path;
+
+    // a dry run finds any conflict first, so a failed merge changes neither value
+    if ((Value::MergePolicy::Fail == policy.conflicts) && !_layer(target, overlay, policy, path, false)) {
+        YaJsonThrow(std::domain_error("type conflict at " + (path.empty() ? std::string("/") : path)));
+    }
+
+    _layer(target, overlay, policy, path, true);
+    overlay = Value();
+}
+
+inline Value Patch::diff(const Value& from, const Value& to, size_t maximumArrayCost) {
+    Value patch = Value::array();
+    std::string path;
+    _Hashes hashes;
+
+    _diff(from, to, path, maximumArrayCost, hashes, patch);
+    return patch;
+}
+
+inline void Patch::_diff(const Value& from, const Value& to, std::string& path, size_t maximumArrayCost,
+                         _Hashes& hashes, Value& patch) {
+    const auto type = from.getType();
+
+    if (_same(from, to, hashes)) {
+        return;
+    } else if (type != to.getType()) {
+        _emit(patch, "replace", path, &to);
+    } else if (Value::Object == type) {
+        // both member maps are in key order, so one merge walk pairs them up
+        const auto& fromMembers = *from.members();
+        const auto& toMembers = *to.members();
+        auto left = fromMembers.begin();
+        auto right = toMembers.begin();
+        const auto length = path.size();
+
+        while ((left != fromMembers.end()) || (right != toMembers.end())) {
+            const bool removed = (right == toMembers.end())
+                                    || ((left != fromMembers.end()) && (left->first < right->first));
+            const bool added = !removed && ((left == fromMembers.end()) || (right->first < left->first));
+
+            Pointer::append(path, removed ? left->first : right->first);
+
+            if (removed) {
+                _emit(patch, "remove", path, nullptr);
+                ++left;
+            } else if (added) {
+                _emit(patch, "add", path, &right->second);
+                ++right;
+            } else {
+                _diff(left->second, right->second, path, maximumArrayCost, hashes, patch);
+                ++left;
+                ++right;
+            }
+
+            path.resize(length);
+        }
+    } else if (Value::Array == type) {
+        _diffArray(from, to, path, maximumArrayCost, hashes, patch);
+    } else {
+        _emit(patch, "replace", path, &to);
+    }
+}
+
+inline void Patch::_diffArray(const Value& fromArray, const Value& toArray, std::string& path,
+                              size_t maximumArrayCost, _Hashes& hashes, Value& patch) {
+    const auto& from = *fromArray.elements();
+    const auto& to = *toArray.elements();
+    size_t prefix = 0;
+    size_t suffix = 0;
+
+    while ((prefix < from.size()) && (prefix < to.size()) && _same(from[prefix], to[prefix], hashes)) {
+        ++prefix;
+    }
+
+    while ((suffix < from.size() - prefix) && (suffix < to.size() - prefix)
+            && _same(from[from.size() - suffix - 1], to[to.size() - suffix - 1], hashes)) {
+        ++suffix;
+    }
+
+    const auto rows = from.size() - prefix - suffix;
+    const auto columns = to.size() - prefix - suffix;
+
+    if ((rows > 0) && (columns > 0) && ((rows + 1) > maximumArrayCost / (columns + 1))) {
+        _emit(patch, "replace", path, &toArray); // too costly to align
+        return;
+    }
+
+    // hashes rule out most unequal pairs before a full comparison
+    std::vector<size_t> fromHashes(rows);
+    std::vector<size_t> toHashes(columns);
+
+    for (size_t row = 0; row < rows; ++row) {
+        fromHashes[row] = _hash(from[prefix + row], hashes);
+    }
+
+    for (size_t column = 0; column < columns; ++column) {
+        toHashes[column] = _hash(to[prefix + column], hashes);
+    }
+
+    const auto same = [&](size_t row, size_t column) {
+        return (fromHashes[row] == toHashes[column]) && (from[prefix + row] == to[prefix + column]);
+    };
+
+    // longest common subsequence of every pair of suffixes
+    std::vector<uint32_t> lengths((rows + 1) * (columns + 1), 0);
+
+    for (size_t row = rows; row > 0; --row) {
+        for (size_t column = columns; column > 0; --column) {
+            const auto cell = (row - 1) * (columns + 1) + (column - 1);
+
+            lengths[cell] = same(row - 1, column - 1) ? lengths[cell + columns + 2] + 1
+                                                      : std::max(lengths[cell + columns + 1], lengths[cell + 1]);
+        }
+    }
+
+    const auto length = path.size();
+    size_t row = 0;
+    size_t column = 0;
+    size_t index = prefix;
+
+    while ((row < rows) || (column < columns)) {
+        const auto cell = row * (columns + 1) + column;
+        const bool match = (row < rows) && (column < columns) && same(row, column);
+        const bool remove = !match && (row < rows)
+                                && ((column == columns) || (lengths[cell + columns + 1] >= lengths[cell + 1]));
+        // a removal paired with an insertion, when that loses nothing, is a change to one element
+        const bool change = !match && (row < rows) && (column < columns)
+                                && (lengths[cell] == lengths[cell + columns + 2]);
+
+        Pointer::append(path, std::to_string(index));
+
+        if (match) {
+            ++row;
+            ++column;
+            ++index;
+        } else if (change) {
+            _diff(from[prefix + row], to[prefix + column], path, maximumArrayCost, hashes, patch);
+            ++row;
+            ++column;
+            ++index;
+        } else if (remove) {
+            _emit(patch, "remove", path, nullptr);
+            ++row;
+        } else {
+            _emit(patch, "add", path, &to[prefix + column]);
+            ++column;
+            ++index;
+        }
+
+        path.resize(length);
+    }
+}
+
+// same result as Value::hash, but each node is hashed once per diff however deep it lies
+inline size_t Patch::_hash(const Value& value, _Hashes& hashes) {
+    const auto found = hashes.find(&value);
+
+    if (found != hashes.end()) {
+        return found->second;
+    }
+
+    size_t result = 0;
+
+    if (value.is(Value::Object)) {
+        result = Instance::combine(Value::Object, value.members()->size());
+
+        for (const auto& member : *value.members()) {
+            result = Instance::combine(Instance::combine(result, std::hash<std::string>()(member.first)),
+                                       _hash(member.second, hashes));
+        }
+    } else if (value.is(Value::Array)) {
+        result = Instance::combine(Value::Array, value.elements()->size());
+
+        for (const auto& element : *value.elements()) {
+            result = Instance::combine(result, _hash(element, hashes));
+        }
+    } else {
+        result = value.hash();
+    }
+
+    hashes[&value] = result;
+    return result;
+}
+
+inline bool Patch::_same(const Value& left, const Value& right, _Hashes& hashes) {
+    return (_hash(left, hashes) == _hash(right, hashes)) && (left == right);
+}
+
+inline bool Patch::_layer(Value& target, Value& overlay, const Value::MergePolicy& policy, std::string& path,
+                          bool apply) {
+    const auto type = target.getType();
+    const auto overlayType = overlay.getType();
+    const bool numbers = ((Value::Integer == type) || (Value::Real == type))
+                            && ((Value::Integer == overlayType) || (Value::Real == overlayType));
+
+    if ((type != overlayType) && !target.isNull() && !overlay.isNull() && !numbers) {
+        if (Value::MergePolicy::Fail == policy.conflicts) {
+            return false;
+        }
+
+        if (apply && (Value::MergePolicy::OverlayWins == policy.conflicts)) {
+            target = std::move(overlay);
+        }
+
+        return true;
+    }
+
+    if ((Value::Object == type) && (Value::Object == overlayType)) {
+        const auto length = path.size();
+
+        for (const auto& member : *overlay.members()) {
+            const auto existing = target.find(member.first);
+
+            if (nullptr != existing) {
+                Pointer::append(path, member.first);
+
+                if (!_layer(*existing, *overlay.find(member.first), policy, path, apply)) {
+                    return false;
+                }
+
+                path.resize(length);
+            } else if (apply) {
+                target.set(member.first, std::move(*overlay.find(member.first)));
+            }
+        }
+
+        return true;
+    }
+
+    if ((Value::Array == type) && (Value::Array == overlayType)) {
+        if (Value::MergePolicy::ByKey == policy.arrays) {
+            return _layerByKey(target, overlay, policy, path, apply);
+        }
+
+        if (Value::MergePolicy::Append == policy.arrays) {
+            if (apply) {
+                target.extend(std::move(overlay));
+            }
+
+            return true;
+        }
+    }
+
+    if (apply) {
+        target = std::move(overlay);
+    }
+
+    return true;
+}
+
+inline bool Patch::_layerByKey(Value& target, Value& overlay, const Value::MergePolicy& policy, std::string& path,
+                               bool apply) {
+    // (key hash, position) of the keyed target elements, sorted so each overlay element finds its match quickly
+    std::vector<std::pair<size_t, size_t>> index;
+    const auto count = static_cast<size_t>(target.count());
+    const auto overlayCount = static_cast<size_t>(overlay.count());
+    const auto length = path.size();
+
+    index.reserve(count);
+
+    for (size_t position = 0; position < count; ++position) {
+        const Value& element = target[position];
+        const auto key = element.is(Value::Object) ? element.find(policy.arrayKey) : nullptr;
+
+        if (nullptr != key) {
+            index.emplace_back(key->hash(), position);
+        }
+    }
+
+    std::sort(index.begin(), index.end());
+
+    for (size_t position = 0; position < overlayCount; ++position) {
+        Value& element = overlay[position];
+        const auto key = element.is(Value::Object) ? element.find(policy.arrayKey) : nullptr;
+        const size_t hash = nullptr != key ? key->hash() : 0;
+        auto match = nullptr != key ? std::lower_bound(index.begin(), index.end(), std::make_pair(hash, size_t(0)))
+                                    : index.end();
+
+        while ((match != index.end()) && (match->first == hash) && (target[match->second][policy.arrayKey] != *key)) {
+            ++match;
+        }
+
+        if ((match != index.end()) && (match->first == hash)) {
+            path.append(1, '/').append(std::to_string(match->second));
+
+            if (!_layer(target[match->second], element, policy, path, apply)) {
+                return false;
+            }
+
+            path.resize(length);
+        } else if (apply) {
+            target.append(std::move(element));
+        }
+    }
+
+    return true;
+}
+
+inline void Patch::_emit(Value& patch, const char* op, const std::string& path, const Value* value) {
+    Value operation = Value::object();
+
+    operation.set("op", op);
+    operation.set("path", path);
+
+    if (nullptr != value) {
+        operation.set("value", *value);
+    }
+
+    patch.append(std::move(operation));
+}
+
+inline bool Patch::_operation(Value& root, const Value& operation, _Log& log, std::string& error) {
+    const auto op = operation.is(Value::Object) ? operation.find("op") : nullptr;
+    const auto path = operation.is(Value::Object) ? operation.find("path") : nullptr;
+    Value::StringList tokens;
+    Value::StringList source;
+
+    if ((nullptr == op) || (nullptr == path) || !op->is(Value::String) || !path->is(Value::String)) {
+        return _fail(error, "missing op or path");
+    }
+
+    if (!Pointer::split(path->stringRef(), tokens)) {
+        return _fail(error, "invalid path");
+    }
+
+    const auto& name = op->stringRef();
+    const auto value = operation.find("value");
+    const auto from = operation.find("from");
+
+    if ((nullptr == value) && (("add" == name) || ("replace" == name) || ("test" == name))) {
+        return _fail(error, "missing value");
+    }
+
+    if ((("move" == name) || ("copy" == name))
+            && ((nullptr == from) || !from->is(Value::String) || !Pointer::split(from->stringRef(), source))) {
+        return _fail(error, "missing or invalid from");
+    }
+
+    if ("add" == name) {
+        Value added(*value);
+
+        return _add(root, tokens, added, log, error);
+    } else if ("remove" == name) {
+        Value removed;
+
+        if (!_remove(root, tokens, removed, error)) {
+            return false;
+        }
+
+        _record(log, _Change::Reinsert, tokens, removed);
+    } else if ("replace" == name) {
+        const auto target = Pointer::resolve(root, tokens, tokens.size());
+        Value replacement;
+
+        if (nullptr == target) {
+            return _fail(error, "path not found");
+        }
+
+        replacement = *value;
+        _record(log, _Change::Restore, tokens, replacement);
+        target->swap(log.back().value);
+    } else if ("move" == name) {
+        Value moved;
+        Value none;
+
+        if ((source.size() < tokens.size()) && std::equal(source.begin(), source.end(), tokens.begin())) {
+            return _fail(error, "cannot move a value into itself");
+        }
+
+        if (source == tokens) {
+            return (nullptr != Pointer::resolve(root, tokens, tokens.size())) || _fail(error, "path not found");
+        }
+
+        if (!_remove(root, source, moved, error)) {
+            return false;
+        }
+
+        // undone after the add: puts back whatever undoing the add took out
+        _record(log, _Change::Reinsert, source, none, true);
+
+        if (!_add(root, tokens, moved, log, error)) {
+            log.back().value.swap(moved);
+            log.back().carried = false;
+            return false;
+        }
+    } else if ("copy" == name) {
+        const auto original = Pointer::resolve(root, source, source.size());
+
+        if (nullptr == original) {
+            return _fail(error, "from not found");
+        }
+
+        Value copied(*original);
+
+        return _add(root, tokens, copied, log, error);
+    } else if ("test" == name) {
+        const auto target = Pointer::resolve(root, tokens, tokens.size());
+
+        if (nullptr == target) {
+            return _fail(error, "path not found");
+        }
+
+        if (*target != *value) {
+            return _fail(error, "test failed");
+        }
+    } else {
+        return _fail(error, "unknown op");
+    }
+
+    return true;
+}
+
+inline bool Patch::_add(Value& root, const Value::StringList& path, Value& value, _Log& log, std::string& error) {
+    const auto parent = path.empty() ? nullptr : Pointer::resolve(root, path, path.size() - 1);
+    Value none;
+
+    if (path.empty()) {
+        _record(log, _Change::Restore, path, value);
+        root.swap(log.back().value);
+    } else if ((nullptr != parent) && parent->is(Value::Object)) {
+        const auto existing = parent->find(Key(path.back()));
+
+        if (nullptr != existing) {
+            _record(log, _Change::Restore, path, value);
+            existing->swap(log.back().value);
+        } else {
+            _record(log, _Change::Remove, path, none);
+            parent->set(path.back(), std::move(value));
+        }
+    } else if ((nullptr != parent) && parent->is(Value::Array)) {
+        const auto size = static_cast<size_t>(parent->count());
+        auto position = path;
+        size_t index = size;
+
+        if (("-" != path.back()) && (!Pointer::index(path.back(), index) || (index > size))) {
+            return _fail(error, "index out of range");
+        }
+
+        position.back() = std::to_string(index);
+        _record(log, _Change::Remove, position, none);
+        parent->insert(std::move(value), index);
     } else {
-        throw std::invalid_argument("invalid codepoint: " + text.substr(offset, 4));
+        return _fail(error, "path not found");
     }
 
-    return codepoint;
+    return true;
 }
 
-inline std::string String::_utf8(size_t codepoint) {
-    /*
-        1  7   U+0000   U+007F    0xxxxxxx
-        2  11  U+0080   U+07FF    110xxxxx  10xxxxxx
-        3  16  U+0800   U+FFFF    1110xxxx  10xxxxxx  10xxxxxx
-        4  21  U+10000  U+10FFFF  11110xxx  10xxxxxx  10xxxxxx  10xxxxxx
-    */
-    std::string value;
+inline bool Patch::_remove(Value& root, const Value::StringList& path, Value& removed, std::string& error) {
+    const auto parent = path.empty() ? nullptr : Pointer::resolve(root, path, path.size() - 1);
+    size_t index = 0;
 
-    if (codepoint <= 0x7F) {
-        value.assign(1, char(codepoint));
-    } else if (codepoint <= 0x7FF) {
-        char buffer[3];
+    if (path.empty()) {
+        return _fail(error, "cannot remove the document");
+    }
 
-        buffer[0] = static_cast<char>((6 << 5) | (codepoint >> 6));
-        buffer[1] = static_cast<char>((2 << 6) | (codepoint & 0x3F));
-        buffer[2] = 0;
-        value = buffer;
-    } else if (codepoint <= 0xFFFF) {
-        char buffer[4];
+    if ((nullptr != parent) && parent->is(Value::Object)) {
+        const auto found = parent->find(Key(path.back()));
 
-        buffer[0] = static_cast<char>((14 << 4) | ( codepoint >> 12));
-        buffer[1] = static_cast<char>((2  << 6) | ((codepoint >> 6) & 0x3F));
-        buffer[2] = static_cast<char>((2  << 6) | ( codepoint & 0x3F));
-        buffer[3] = 0;
-        value = buffer;
-    } else if (codepoint <= 0x10FFFF) {
-        char buffer[5];
+        if (nullptr == found) {
+            return _fail(error, "path not found");
+        }
 
-        buffer[0] = static_cast<char>((30 << 3) | (codepoint >> 18));
-        buffer[1] = static_cast<char>((2 << 6) | ((codepoint >> 12) & 0x3F));
-        buffer[2] = static_cast<char>((2 << 6) | ((codepoint >> 6) & 0x3F));
-        buffer[3] = static_cast<char>((2 << 6) | (codepoint & 0x3F));
-        buffer[4] = 0;
-        value = buffer;
+        removed.swap(*found);
+        parent->erase(path.back());
+    } else if ((nullptr != parent) && parent->is(Value::Array)) {
+        if (!Pointer::index(path.back(), index) || (index >= static_cast<size_t>(parent->count()))) {
+            return _fail(error, "index out of range");
+        }
+
+        removed.swap(parent->get(index));
+        parent->erase(index, index + 1);
     } else {
-        throw std::invalid_argument("invalid codepoint: " 
-                                    + std::to_string(codepoint));
+        return _fail(error, "path not found");
     }
 
-    return value;
+    return true;
 }
 
-inline void String::_parseEscaped(const std::string& text, size_t& offset, std::string& result) {
-    offset += 1; // skip backslash (\) escape character
+inline void Patch::_merge(Value& target, const Value& patch, Value::StringList& path, _Log& log) {
+    if (!patch.is(Value::Object)) {
+        Value replacement(patch);
 
-    switch (text[offset]) {
-        case '/':
-            result += '/';
-            break;
-        case '"':
-            result += '"';
-            break;
-        case '\\':
-            result += '\\';
-            break;
-        case 'b':
-            result += '\b';
-            break;
-        case 'f':
-            result += '\f';
-            break;
-        case 'r':
-            result += '\r';
-            break;
-        case 'n':
-            result += '\n';
-            break;
-        case 't':
-            result += '\t';
-            break;
-        case 'u':
-            _parseEscapedUnicode(text, offset, result);
-            break;
-        default:
-            throw std::invalid_argument(std::string("Illegal escape: ") + text[offset]);
+        _record(log, _Change::Restore, path, replacement);
+        target.swap(log.back().value);
+        return;
     }
-    
-    offset += 1;
-}
-
-inline void String::_parseEscapedUnicode(const std::string& text, size_t& offset, std::string& result) {
-    long value;
-    size_t count = 0;
 
-    if (text[offset + 1] == '{') {
-        const std::string::size_type end = text.find('}', offset + 2);
-        const std::string::size_type size = end - offset - 2;
+    if (!target.is(Value::Object)) {
+        Value object = Value::object();
 
-        YaJsonAssert(std::string::npos != end);
-        YaJsonAssert(offset + 2 != end);
-        value = std::stol(text.substr(offset + 2, size), &count, 16);
-        YaJsonAssert(count == size);
-        offset += 1 + size + 1;
-    } else {
-        value = std::stol(text.substr(offset + 1, 4), &count, 16);
-        YaJsonAssert(count == 4);
-        offset += 4;
+        _record(log, _Change::Restore, path, object);
+        target.swap(log.back().value);
     }
 
-    result += _utf8(static_cast<size_t>(value));
-}
+    for (const auto& member : *patch.members()) {
+        const auto existing = target.find(member.first);
 
-inline Integer::Integer(const int64_t value)
-    :_value(value) {}
+        path.push_back(member.first);
 
-inline Instance *Integer::clone() const {
-    return new Integer(_value);
-}
+        if (member.second.isNull()) {
+            if (nullptr != existing) {
+                Value removed;
 
-inline void Integer::format(std::string &buffer, int /*indent*/, int /*indentLevel*/) const {
-    buffer = std::to_string(_value);
-}
+                removed.swap(*existing);
+                target.erase(member.first);
+                _record(log, _Change::Reinsert, path, removed);
+            }
+        } else if (nullptr != existing) {
+            _merge(*existing, member.second, path, log);
+        } else {
+            _Log scratch; // a new member has nothing beneath it to restore
+            Value added;
+            Value none;
 
-inline bool Integer::equals(const Instance& other) const {
-    if (!Instance::equals(other)) {
-        return false;
+            _merge(added, member.second, path, scratch);
+            _record(log, _Change::Remove, path, none);
+            target.set(member.first, std::move(added));
+        }
+
+        path.pop_back();
     }
+}
 
-    return _value == dynamic_cast<const Integer*>(&other)->_value;
+inline void Patch::_record(_Log& log, _Change::Kind kind, const Value::StringList& path, Value& value,
+                           bool carried) {
+    log.push_back(_Change{kind, path, std::move(value), carried});
 }
 
-inline Value::Type Integer::getType() const {
-    return Value::Integer;
+inline void Patch::_rollback(Value& root, _Log& log) {
+    Value carry;
+
+    for (auto change = log.rbegin(); change != log.rend(); ++change) {
+        const auto& path = change->path;
+        const auto parent = path.empty() ? nullptr : Pointer::resolve(root, path, path.size() - 1);
+        const auto target = Pointer::resolve(root, path, path.size());
+        size_t index = 0;
+
+        if (nullptr == (_Change::Reinsert == change->kind ? parent : target)) {
+            continue; // the change was interrupted before it was made
+        }
+
+        switch (change->kind) {
+            case _Change::Restore:
+                carry.swap(*target);
+                target->swap(change->value);
+                break;
+            case _Change::Remove:
+                carry.swap(*target);
+
+                if (parent->is(Value::Object)) {
+                    parent->erase(path.back());
+                } else if (Pointer::index(path.back(), index)) {
+                    parent->erase(index, index + 1);
+                }
+                break;
+            case _Change::Reinsert:
+            default: {
+                Value& value = change->carried ? carry : change->value;
+
+                if (parent->is(Value::Object)) {
+                    parent->set(path.back(), std::move(value));
+                } else if (Pointer::index(path.back(), index)) {
+                    parent->insert(std::move(value), index);
+                }
+                break;
+            }
+        }
+    }
 }
 
-inline int64_t Integer::integer() const {
-    return _value;
+inline bool Patch::_fail(std::string& error, const char* message) {
+    error = message;
+    return false;
 }
 
-inline Real::Real(const double value)
-    :_value(value) {}
+inline FrozenValue::FrozenValue()
+    :FrozenValue(Value()) {}
 
-inline Instance *Real::clone() const {
-    return new Real(_value);
+inline FrozenValue::FrozenValue(const Value& value)
+    :FrozenValue(std::make_shared<const std::string>(Snapshot::write(value))) {}
+
+inline FrozenValue::FrozenValue(const std::shared_ptr<const std::string>& buffer)
+    :SnapshotView(buffer->data(), buffer->size()), _buffer(buffer) {}
+
+inline FrozenValue::FrozenValue(const SnapshotView& view, const std::shared_ptr<const std::string>& buffer)
+    :SnapshotView(view), _buffer(buffer) {}
+
+inline FrozenValue FrozenValue::member(size_t index) const {
+    return FrozenValue(SnapshotView::member(index), _buffer);
 }
 
-inline void Real::format(std::string &buffer, int /*indent*/, int /*indentLevel*/) const {
-    buffer = std::to_string(_value);
+inline FrozenValue FrozenValue::at(const Key& key) const {
+    return FrozenValue(SnapshotView::at(key), _buffer);
 }
 
-inline bool Real::equals(const Instance& other) const {
-    if (!Instance::equals(other)) {
-        return false;
-    }
-    
-    const auto a = _value;
-    const auto b = dynamic_cast<const Real*>(&other)->_value;
-    const auto epsilon = std::numeric_limits<double>::epsilon();
-    const auto highest = std::max(std::abs(a), std::abs(b));
-    return std::abs(a - b) < epsilon * highest;
+inline FrozenValue FrozenValue::at(size_t index) const {
+    return FrozenValue(SnapshotView::at(index), _buffer);
 }
 
-inline Value::Type Real::getType() const {
-    return Value::Real;
+inline FrozenValue FrozenValue::operator[](const Key& key) const {
+    return FrozenValue(SnapshotView::operator[](key), _buffer);
 }
 
-inline double Real::real() const {
-    return _value;
+inline FrozenValue FrozenValue::operator[](size_t index) const {
+    return FrozenValue(SnapshotView::operator[](index), _buffer);
 }
 
-inline Boolean::Boolean(const bool value)
-    :_value(value) {}
+inline const SnapshotView& FrozenValue::view() const {
+    return *this;
+}
 
-inline Instance *Boolean::clone() const {
-    return new Boolean(_value);
+inline const char* FrozenValue::data() const {
+    return _buffer->data();
 }
 
-inline void Boolean::format(std::string &buffer, int /*indent*/, int /*indentLevel*/) const {
-    buffer = _value ? "true" : "false";
+inline size_t FrozenValue::size() const {
+    return _buffer->size();
 }
 
-inline bool Boolean::equals(const Instance& other) const {
-    if (!Instance::equals(other)) {
+inline Cursor::Cursor(std::istream& stream, size_t bufferSize)
+    :_stream(stream), _bufferSize(0 == bufferSize ? 1 : bufferSize), _buffer(), _start(0), _discarded(0),
+     _levels(), _key(), _first(true), _pending(true), _end(false), _error() {}
+
+inline bool Cursor::enter() {
+    YaJsonAssert(_pending);
+
+    if (_error.code != Value::ParseError::None) {
         return false;
     }
 
-    return _value == dynamic_cast<const Boolean*>(&other)->_value;
-}
+    const char character = _peek();
 
-inline Value::Type Boolean::getType() const {
-    return Value::Boolean;
-}
+    if (('[' != character) && ('{' != character)) {
+        return _fail(('\0' == character) ? Value::ParseError::UnexpectedEnd : Value::ParseError::TypeMismatch, _start);
+    }
 
-inline bool Boolean::boolean() const {
-    return _value;
+    if (_levels.size() >= Parser::MaximumDepth) {
+        return _fail(Value::ParseError::NestingTooDeep, _start);
+    }
+
+    _start += 1;
+    _levels.push_back(('[' == character) ? ']' : '}');
+    _first = true;
+    _pending = false;
+    return true;
 }
 
-inline Array* Array::parse(const std::string& text, size_t& offset) {
-    auto result = std::unique_ptr<Array>(new Array({}));
-    offset += 1; // skip [
+inline bool Cursor::next() {
+    YaJsonAssert(!_levels.empty());
+
+    if ((_error.code != Value::ParseError::None) || (_pending && !skip())) {
+        return false;
+    }
 
-    while ((offset < text.length()) && (text[offset] != ']')) {
-        offset = Value::skipWhitespace(text, offset);
+    char character = _peek();
 
-        if (']' == text[offset]) {
-            break; // end of array
+    if (_levels.back() == character) {
+        _start += 1;
+        _levels.pop_back();
+        _first = false;
+
+        if (_levels.empty()) {
+            _finish();
         }
-        
-        auto value = Value::parse(text, &offset);
-        result->append(value);
 
-        offset = Value::skipWhitespace(text, offset);
-        YaJsonAssert(',' == text[offset] || ']' == text[offset]);
+        return false;
+    }
 
-        if (',' == text[offset]) {
-            offset += 1; // skip ,
-            offset = Value::skipWhitespace(text, offset);
+    if (!_first) {
+        if (',' != character) {
+            return _fail(('\0' == character) ? Value::ParseError::UnexpectedEnd : Value::ParseError::UnexpectedCharacter,
+                            _start);
         }
+
+        _start += 1;
     }
 
-    offset += 1; // skip ]
-    YaJsonAssert(offset <= text.length());
-    return result.release();
-}
+    _first = false;
 
-inline Array::Array(const std::vector<Value>& value)
-    :_value(value) {}
+    if ('}' == _levels.back()) {
+        size_t end = 0;
 
-inline Instance *Array::clone() const {
-    return new Array(_value);
-}
+        character = _peek();
 
-inline void Array::format(std::string &buffer, int indent, int indentLevel) const {
-    std::string value;
-    std::string suffix = ",";
-    std::string linePrefix = "";
-    std::string lastLinePrefix = "";
-    std::string lineSuffix = (indent >= 0) ? "\n" : "";
+        if ('"' != character) {
+            return _fail(('\0' == character) ? Value::ParseError::UnexpectedEnd : Value::ParseError::UnexpectedCharacter,
+                            _start);
+        }
 
-    if (indent >= 0) {
-        const auto lastIndents = static_cast<size_t>(indent * indentLevel);
-        const auto indents = lastIndents + static_cast<size_t>(indent);
-        linePrefix.assign(indents, ' ');
-        lastLinePrefix.assign(lastIndents, ' ');
-    }
+        if (!_span(end)) {
+            return false;
+        }
 
-    buffer = "[" + lineSuffix;
+        Parser parser(_buffer.data(), end, _start);
 
-    for (auto i = _value.begin(); i != _value.end(); ++i) {
-        i->format(value, indent, indentLevel + 1);
+        _key.clear();
 
-        if ((i + 1) == _value.end()) {
-            suffix = "";
+        if (!String::parse(parser, &_key)) {
+            return _fail(parser.error().code, parser.error().offset);
         }
 
-        buffer += linePrefix + value + suffix + lineSuffix;
-    }
+        _start = end;
+        character = _peek();
 
-    buffer += lastLinePrefix + "]";
-}
+        if (':' != character) {
+            return _fail(('\0' == character) ? Value::ParseError::UnexpectedEnd : Value::ParseError::UnexpectedCharacter,
+                            _start);
+        }
 
-inline bool Array::equals(const Instance& other) const {
-    if (!Instance::equals(other)) {
-        return false;
+        _start += 1;
     }
 
-    return _value == dynamic_cast<const Array*>(&other)->_value;
+    _pending = true;
+    return true;
 }
 
-inline Value::Type Array::getType() const {
-    return Value::Array;
+inline bool Cursor::read(Value& value) {
+    return _read(value, nullptr);
 }
 
-inline int Array::count() const {
-    return _value.size();
+inline bool Cursor::read(Value& value, const Projection& projection) {
+    return _read(value, &projection);
 }
 
-inline Value& Array::get(const std::string& key) {
-    return Instance::get(key);
-}
+inline bool Cursor::skip() {
+    YaJsonAssert(_pending);
 
-inline Value& Array::get(size_t index) {
-    while (index >= _value.size()) {
-        _value.push_back(Value());
+    size_t end = 0;
+
+    if ((_error.code != Value::ParseError::None) || !_span(end)) {
+        return false;
     }
 
-    return _value[index];
+    _start = end;
+    _pending = false;
+    return !_levels.empty() || _finish();
 }
 
-inline void Array::clear() {
-    _value.clear();
+inline const std::string& Cursor::key() const {
+    return _key;
 }
 
-inline void Array::erase(size_t start, size_t end) {
-    const auto arraySize = _value.size();
-
-    if (start >= arraySize) {
-        return;
-    }
-
-    const auto startIter = _value.begin() + static_cast<int>(start);
-    const auto endIter = end >= arraySize 
-                        ? _value.end() 
-                        : _value.begin() + static_cast<int>(end);
+inline bool Cursor::done() const {
+    return _levels.empty() && !_pending && (_error.code == Value::ParseError::None);
+}
 
-    _value.erase(startIter, endIter);
+inline bool Cursor::failed() const {
+    return _error.code != Value::ParseError::None;
 }
 
-inline void Array::erase(const std::string& key) {
-    return Instance::erase(key);
+inline size_t Cursor::offset() const {
+    return _discarded + _start;
 }
 
-inline void Array::append(const Value& value) {
-    _value.push_back(value);
+inline const Value::ParseError& Cursor::error() const {
+    return _error;
 }
 
-inline void Array::insert(const Value& value, size_t before) {
-    const auto arraySize = _value.size();
-    const auto beforeIter = before >= arraySize 
-                            ? _value.end()
-                            : _value.begin() + static_cast<int>(before);
+inline bool Cursor::_fill() {
+    if (_end) {
+        return false;
+    }
 
-    _value.insert(beforeIter, value);
-}
+    _buffer.erase(0, _start);
+    _discarded += _start;
+    _start = 0;
 
-inline Object* Object::parse(const std::string& text, size_t& offset) {
-    auto result = std::unique_ptr<Object>(new Object({}));
-    offset += 1; // skip {
+    const size_t size = _buffer.size();
+    const size_t block = std::max(_bufferSize, size); // so rescanning a long record stays linear
 
-    while ((offset < text.length()) && (text[offset] != '}')) {
-        offset = Value::skipWhitespace(text, offset);
-        YaJsonAssert(offset < text.length());
+    _buffer.resize(size + block);
+    _stream.read(&_buffer[size], static_cast<std::streamsize>(block));
 
-        if ('}' == text[offset]) {
-            break; // end of object
-        }
+    const size_t count = static_cast<size_t>(_stream.gcount());
 
-        YaJsonAssert('"' == text[offset]);
-        auto key = String::parse(text, offset);
-        offset = Value::skipWhitespace(text, offset);
+    _buffer.resize(size + count);
+    _end = (0 == count) || !_stream.good();
+    return count > 0;
+}
 
-        YaJsonAssert(offset < text.length());
-        YaJsonAssert(':' == text[offset]);
-        offset += 1; // skip :
+inline char Cursor::_peek() {
+    while (true) {
+        while ((_start < _buffer.size()) && (' ' == _buffer[_start] || '\t' == _buffer[_start]
+                                                || '\r' == _buffer[_start] || '\n' == _buffer[_start])) {
+            _start += 1;
+        }
 
-        auto value = Value::parse(text, &offset);
-        result->set(key, value);
-        offset = Value::skipWhitespace(text, offset);
-        YaJsonAssert(',' == text[offset] || '}' == text[offset]);
+        if (_start < _buffer.size()) {
+            return _buffer[_start];
+        }
 
-        if (',' == text[offset]) {
-            offset += 1; // skip ,
-            offset = Value::skipWhitespace(text, offset);
+        if (!_fill()) {
+            return '\0';
         }
     }
-
-    offset += 1; // skip }
-    YaJsonAssert(offset <= text.length());
-    return result.release();
 }
 
-inline Object::Object(const std::map<std::string, Value>& value)
-    :_value(value) {}
+inline bool Cursor::_span(size_t& end) {
+    while (true) {
+        _peek();
 
-inline Instance *Object::clone() const {
-    return new Object(_value);
-}
+        Parser parser(_buffer.data(), _buffer.size(), _start);
+        const bool complete = parser.scan(_levels.size());
 
-inline void Object::format(std::string &buffer, int indent, int indentLevel) const {
-    Value key;
-    std::string keyStr;
-    std::string value;
-    std::string linePrefix = "";
-    std::string lastLinePrefix = "";
-    std::string lineSuffix = (indent >= 0) ? "\n" : "";
-    size_t itemsLeft = _value.size();
+        // a scalar that runs to the end of the buffer may continue in the stream
+        if (complete ? ((parser.offset() < _buffer.size()) || _end)
+                     : ((parser.error().code != Value::ParseError::UnexpectedEnd) || _end)) {
+            if (!complete) {
+                return _fail(parser.error().code, parser.error().offset);
+            }
 
-    if (indent >= 0) {
-        const auto lastIndents = static_cast<size_t>(indent * indentLevel);
-        const auto indents = lastIndents + static_cast<size_t>(indent);
-        linePrefix.assign(indents, ' ');
-        lastLinePrefix.assign(lastIndents, ' ');
+            end = parser.offset();
+            return true;
+        }
+
+        _fill();
     }
+}
+
+inline bool Cursor::_read(Value& value, const Projection* projection) {
+    YaJsonAssert(_pending);
 
-    buffer = "{" + lineSuffix;
+    size_t end = 0;
 
-    for (auto i : _value) {
-        itemsLeft -= 1;
-        key = i.first;
-        key.format(keyStr, indent, indentLevel + 1);
-        i.second.format(value, indent, indentLevel + 1);
-        buffer += linePrefix + keyStr + ":" + value + (itemsLeft == 0 ? "" : ",")
-                    + lineSuffix;
+    if ((_error.code != Value::ParseError::None) || !_span(end)) {
+        return false;
     }
 
-    buffer += lastLinePrefix + "}";
-}
+    Parser parser(_buffer.data(), end, _start);
 
-inline bool Object::equals(const Instance& other) const {
-    if (!Instance::equals(other)) {
-        return false;
+    if (!(nullptr == projection ? parser.parse(value) : parser.parse(value, *projection))) {
+        return _fail(parser.error().code, parser.error().offset);
     }
 
-    return _value == dynamic_cast<const Object*>(&other)->_value;
-}
+    if (parser.offset() != end) {
+        return _fail(Value::ParseError::UnexpectedCharacter, parser.offset());
+    }
 
-inline Value::Type Object::getType() const {
-    return Value::Object;
+    _start = end;
+    _pending = false;
+    return !_levels.empty() || _finish();
 }
 
-inline int Object::count() const {
-    return _value.size();
+inline bool Cursor::_finish() {
+    return ('\0' == _peek()) || _fail(Value::ParseError::UnexpectedCharacter, _start);
 }
 
-inline Value::StringList Object::keys() const {
-    Value::StringList keys;
-    
-    keys.reserve(_value.size());
-    std::transform(_value.begin(), _value.end(), std::back_inserter(keys),
-                   [](const std::pair<std::string, Value>& pair) { return pair.first; });
-    return keys;
+inline bool Cursor::_fail(Value::ParseError::Code code, size_t offset) {
+    _error.code = code;
+    _error.offset = _discarded + offset;
+    return false;
 }
 
-inline bool Object::has(const std::string& key) {
-    return _value.find(key) != _value.end();
+#ifdef _WIN32
+inline MappedFile::MappedFile(const std::string& path)
+    :_contents(), _size(0) {
+    // no shared mapping here: read the file into memory instead
+    const int descriptor = ::_open(path.c_str(), _O_RDONLY | _O_BINARY);
+    char buffer[4096];
+
+    if (descriptor < 0) {
+        YaJsonThrow(std::runtime_error("open failed: " + std::to_string(errno)));
+    }
+
+    for (int got = ::_read(descriptor, buffer, sizeof(buffer)); got > 0;
+            got = ::_read(descriptor, buffer, sizeof(buffer))) {
+        _contents.append(buffer, static_cast<size_t>(got));
+    }
+
+    ::_close(descriptor);
+    _size = _contents.size();
 }
 
-inline Value& Object::get(const std::string& key) {
-    return _value[key];
+inline MappedFile::~MappedFile() {}
+
+inline const char* MappedFile::data() const {
+    return _contents.data();
 }
+#else
+inline MappedFile::MappedFile(const std::string& path)
+    :_mapping(nullptr), _size(0) {
+    const int descriptor = ::open(path.c_str(), O_RDONLY);
+    struct stat status;
 
-inline Value& Object::get(size_t index) {
-    return Instance::get(index);
+    if ((descriptor < 0) || (0 != ::fstat(descriptor, &status))) {
+        const auto error = errno; // before close() can overwrite it
+
+        (void)error; // only read when exceptions are enabled
+
+        if (descriptor >= 0) {
+            ::close(descriptor);
+        }
+
+        YaJsonThrow(std::runtime_error("open failed: " + std::to_string(error)));
+    }
+
+    _size = static_cast<size_t>(status.st_size);
+
+    if (_size > 0) {
+        _mapping = ::mmap(nullptr, _size, PROT_READ, MAP_SHARED, descriptor, 0);
+    }
+
+    ::close(descriptor);
+
+    if (MAP_FAILED == _mapping) {
+        _mapping = nullptr;
+        YaJsonThrow(std::runtime_error("mmap failed: " + std::to_string(errno)));
+    }
 }
 
-inline void Object::clear() {
-    _value.clear();
+inline MappedFile::~MappedFile() {
+    if (nullptr != _mapping) {
+        ::munmap(_mapping, _size);
+    }
 }
 
-inline void Object::erase(const std::string& key) {
-    _value.erase(key);
+inline const char* MappedFile::data() const {
+    return static_cast<const char*>(_mapping);
 }
+#endif
 
-inline void Object::erase(size_t start, size_t end) {
-    return Instance::erase(start, end);
+inline size_t MappedFile::size() const {
+    return _size;
 }
 
-inline void Object::set(const std::string& key, const Value& value) {
-    _value[key] = value;
+inline SnapshotView MappedFile::snapshot() const {
+    return SnapshotView(data(), size());
 }
 
 #pragma GCC diagnostic pop
 #undef YaJsonAssert
+#undef YaJsonThrow
+}
+
+namespace std {
+
+template<> struct hash<yajson::Value> {
+    size_t operator()(const yajson::Value& value) const {
+        return value.hash();
+    }
+};
+
 }